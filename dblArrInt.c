@@ -0,0 +1,487 @@
+/*
+ * dblArrInt.c
+ * Author:Qiwei Li
+ *
+ * Array-backed doubly linked lists of ints; see dblArrInt.h.
+ *
+ * Walking a DblList_Int means one pointer dereference (and, for a big list,
+ * usually one cache miss) per node, since each node is its own malloc()ed
+ * object.  Here, the links are 4-byte indices instead of 8-byte pointers,
+ * and they sit in their own arrays, apart from the values: a walk only
+ * touches the 'next' array, and a scan of the values only touches 'val'.
+ * After compact(), a list is laid out in order, so that walking it is a
+ * plain array loop, which the compiler can vectorize.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "dblArrInt.h"
+
+/* Marks a slot which is on the free list (in its 'prev' entry) */
+#define DBLARR_INT_FREE		0xfffffffeu
+
+#define DBLARR_INT_MIN_CAP	64
+
+/* Returns nonzero if 'node' is a slot which is in use */
+static int dblArr_Int__valid(DblArr_Int *arr, uint32_t node)
+{
+	return node < arr->size && arr->prev[node] != DBLARR_INT_FREE;
+}
+
+/* Grows the three arrays to hold at least 'cap' slots.  Returns -1 if
+ * realloc() fails (the arrays that were already grown are kept; they are
+ * simply a bit bigger than they need to be).
+ */
+static int dblArr_Int__grow(DblArr_Int *arr, uint32_t cap)
+{
+	void *val, *prev, *next;
+
+	val = realloc(arr->val, sizeof(int) * (size_t)cap);
+	if (!val) {
+		perror("realloc");
+		return -1;
+	}
+	arr->val = (int *)val;
+
+	prev = realloc(arr->prev, sizeof(uint32_t) * (size_t)cap);
+	if (!prev) {
+		perror("realloc");
+		return -1;
+	}
+	arr->prev = (uint32_t *)prev;
+
+	next = realloc(arr->next, sizeof(uint32_t) * (size_t)cap);
+	if (!next) {
+		perror("realloc");
+		return -1;
+	}
+	arr->next = (uint32_t *)next;
+
+	arr->cap = cap;
+	return 0;
+}
+
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: capacity (number of nodes to make room for; may be 0)
+//             NOTE: no 'this' pointer
+//
+// Allocates a new DblArr_Int object, which holds no nodes yet.  The arrays
+// grow (by doubling) as nodes are allocated, so the capacity is only a hint.
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+DblArr_Int *dblArr_Int__alloc(uint32_t capacity)
+{
+	DblArr_Int *arr;
+
+	arr = (DblArr_Int *)malloc(sizeof(DblArr_Int));
+	if (!arr) {
+		perror("malloc");
+		return NULL;
+	}
+
+	arr->val = NULL;
+	arr->prev = NULL;
+	arr->next = NULL;
+	arr->size = 0;
+	arr->cap = 0;
+	arr->freeSlots = DBLARR_INT_NIL;
+	arr->live = 0;
+
+	if (capacity && dblArr_Int__grow(arr, capacity) < 0) {
+		dblArr_Int__free(arr);
+		return NULL;
+	}
+
+	return arr;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer
+//
+// Frees the DblArr_Int, and every node in it, in O(1).  The nodes may still
+// be linked into lists; those lists simply go away too.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void dblArr_Int__free(DblArr_Int *arr)
+{
+	if (!arr) {
+		fprintf(stderr, "dblArr_Int__free: The object is NULL.\n");
+		return;
+	}
+
+	free(arr->val);
+	free(arr->prev);
+	free(arr->next);
+	free(arr);
+}
+
+
+// ---------------- allocNode -------------------------------
+// Parameters: 'this' pointer
+//             int (value for the new node)
+//
+// Equivalent to dblList_Int__alloc().  Returns the index of a new node,
+// which is not on any list: a slot from the free list if there is one,
+// otherwise the next unused slot (growing the arrays if they are full).
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return DBLARR_INT_NIL.
+//   - realloc() fails, or the arrays can't grow any more.  Print error and
+//     return DBLARR_INT_NIL.
+
+uint32_t dblArr_Int__allocNode(DblArr_Int *arr, int val)
+{
+	uint32_t node;
+
+	if (!arr) {
+		fprintf(stderr, "dblArr_Int__allocNode: The object is NULL.\n");
+		return DBLARR_INT_NIL;
+	}
+
+	if (arr->freeSlots != DBLARR_INT_NIL) {
+		/* Reuse a slot that was given back */
+		node = arr->freeSlots;
+		arr->freeSlots = arr->next[node];
+	} else {
+		if (arr->size == arr->cap) {
+			uint32_t cap;
+
+			/* The two largest indices are reserved */
+			if (arr->cap >= DBLARR_INT_FREE) {
+				fprintf(stderr, "dblArr_Int__allocNode: The list is full.\n");
+				return DBLARR_INT_NIL;
+			}
+			if (arr->cap < DBLARR_INT_MIN_CAP)
+				cap = DBLARR_INT_MIN_CAP;
+			else if (arr->cap < DBLARR_INT_FREE / 2)
+				cap = arr->cap * 2;
+			else
+				cap = DBLARR_INT_FREE;
+
+			if (dblArr_Int__grow(arr, cap) < 0)
+				return DBLARR_INT_NIL;
+		}
+		node = arr->size++;
+	}
+
+	/* Initialize the node */
+	arr->val[node] = val;
+	arr->prev[node] = DBLARR_INT_NIL;
+	arr->next[node] = DBLARR_INT_NIL;
+	arr->live++;
+
+	return node;
+}
+
+// ---------------- freeNode --------------------------------
+// Parameters: 'this' pointer
+//             node
+//
+// Equivalent to dblList_Int__free(): the slot is put on the free list, to be
+// reused by a later allocNode().  The node must not be part of any list.
+//
+// ERRORS:
+//   - Pointer is NULL, or the node is not in use.  Print error.
+//   - The node has non-NIL next or prev indices.  Print error, but still
+//     free the node before returning.
+
+void dblArr_Int__freeNode(DblArr_Int *arr, uint32_t node)
+{
+	if (!arr || !dblArr_Int__valid(arr, node)) {
+		fprintf(stderr, "dblArr_Int__freeNode: The object is NULL, or the node is invalid.\n");
+		return;
+	}
+
+	/* Sanity check */
+	if (arr->prev[node] != DBLARR_INT_NIL || arr->next[node] != DBLARR_INT_NIL)
+		fprintf(stderr, "dblArr_Int__freeNode: The existing node has non-NIL next or prev indices.\n");
+
+	/* Free the node anyway */
+	arr->prev[node] = DBLARR_INT_FREE;
+	arr->next[node] = arr->freeSlots;
+	arr->freeSlots = node;
+	arr->live--;
+}
+
+
+// ---------------- gettors (various) -----------------------
+// Parameters: 'this' pointer
+//             node
+//
+// Returns various properties of the list node.
+//
+// ERRORS: None
+//         (the node might be out of range; just let it segfault)
+
+int dblArr_Int__getVal(DblArr_Int *arr, uint32_t node)
+{
+	return arr->val[node];
+}
+uint32_t dblArr_Int__getNext(DblArr_Int *arr, uint32_t node)
+{
+	return arr->next[node];
+}
+uint32_t dblArr_Int__getPrev(DblArr_Int *arr, uint32_t node)
+{
+	return arr->prev[node];
+}
+
+
+// ---------------- getHead ---------------------------------
+// Parameters: 'this' pointer
+//             node
+//
+// Searches toward the front of the list, from the given node; returns the
+// node at the head of the list.  (This might be the given node.)
+//
+// getTail(): Equivalent, but finds the last element
+//
+// ERRORS:
+//   - Pointer is NULL, or the node is not in use.  Print error and return
+//     DBLARR_INT_NIL.
+
+uint32_t dblArr_Int__getHead(DblArr_Int *arr, uint32_t node)
+{
+	if (!arr || !dblArr_Int__valid(arr, node)) {
+		fprintf(stderr, "dblArr_Int__getHead: The object is NULL, or the node is invalid.\n");
+		return DBLARR_INT_NIL;
+	}
+
+	/* Search toward the front of the list */
+	while (arr->prev[node] != DBLARR_INT_NIL)
+		node = arr->prev[node];
+
+	return node;
+}
+uint32_t dblArr_Int__getTail(DblArr_Int *arr, uint32_t node)
+{
+	if (!arr || !dblArr_Int__valid(arr, node)) {
+		fprintf(stderr, "dblArr_Int__getTail: The object is NULL, or the node is invalid.\n");
+		return DBLARR_INT_NIL;
+	}
+
+	/* Search toward the tail of the list */
+	while (arr->next[node] != DBLARR_INT_NIL)
+		node = arr->next[node];
+
+	return node;
+}
+
+
+// ---------------- addAfter --------------------------------
+// Parameters: 'this' pointer
+//             pos (a node, which is part of a list)
+//             node (another node)
+//
+// Chains 'node' immediately after 'pos', exactly like dblList_Int__addAfter().
+//
+// ERRORS:
+//   - Pointer is NULL, or either node is not in use.  Print error.
+//   - 'node' is already on a list.  Print error and return; do *NOT* change
+//     either list.
+
+void dblArr_Int__addAfter(DblArr_Int *arr, uint32_t pos, uint32_t node)
+{
+	uint32_t next;
+
+	if (!arr || !dblArr_Int__valid(arr, pos) || !dblArr_Int__valid(arr, node)) {
+		fprintf(stderr, "dblArr_Int__addAfter: The object is NULL, or the node(s) is invalid.\n");
+		return;
+	}
+
+	/* Sanity check */
+	if (arr->prev[node] != DBLARR_INT_NIL || arr->next[node] != DBLARR_INT_NIL) {
+		fprintf(stderr, "dblArr_Int__addAfter: The node is already on a list.\n");
+		return;
+	}
+
+	next = arr->next[pos];
+	arr->prev[node] = pos;
+	arr->next[node] = next;
+	if (next != DBLARR_INT_NIL)
+		arr->prev[next] = node;
+	arr->next[pos] = node;
+}
+
+// ---------------- addTail ---------------------------------
+// Parameters: 'this' pointer
+//             list (any node of the list)
+//             *value*
+//
+// Searches for the tail end of the list; allocates a new node (using the
+// value given), and appends it to the tail of the list.  Returns nothing.
+//
+// ERRORS:
+//   - Pointer is NULL, or the node is not in use.  Print error.
+
+void dblArr_Int__addTail(DblArr_Int *arr, uint32_t list, int value)
+{
+	uint32_t tail, node;
+
+	/* Get tail of the list */
+	tail = dblArr_Int__getTail(arr, list);
+	/* Errors should be handled in dblArr_Int__getTail */
+	if (tail == DBLARR_INT_NIL)
+		return;
+
+	/* Alloc a new node */
+	node = dblArr_Int__allocNode(arr, value);
+	/* Errors should be handled in dblArr_Int__allocNode */
+	if (node == DBLARR_INT_NIL)
+		return;
+
+	/* Insert the node after tail of the list */
+	dblArr_Int__addAfter(arr, tail, node);
+}
+
+// ---------------- remove ---------------------------------
+// Parameters: 'this' pointer
+//             node
+//
+// Removes the node from the list it is part of.
+//
+// ERRORS:
+//   - Pointer is NULL, or the node is not in use.  Print error.
+//   - The node is not part of any list (that is, next==prev==NIL).  Print
+//     error.
+
+void dblArr_Int__remove(DblArr_Int *arr, uint32_t node)
+{
+	uint32_t prev, next;
+
+	if (!arr || !dblArr_Int__valid(arr, node)) {
+		fprintf(stderr, "dblArr_Int__remove: The object is NULL, or the node is invalid.\n");
+		return;
+	}
+
+	prev = arr->prev[node];
+	next = arr->next[node];
+
+	/* Sanity check */
+	if (prev == DBLARR_INT_NIL && next == DBLARR_INT_NIL) {
+		fprintf(stderr, "dblArr_Int__remove: The node is not part of any list.\n");
+		return;
+	}
+
+	/* Remove the node from the list */
+	if (prev != DBLARR_INT_NIL)
+		arr->next[prev] = next;
+	if (next != DBLARR_INT_NIL)
+		arr->prev[next] = prev;
+
+	/* Reset the node */
+	arr->prev[node] = DBLARR_INT_NIL;
+	arr->next[node] = DBLARR_INT_NIL;
+}
+
+// ---------------- swapWithNext ----------------------------
+// Parameters: 'this' pointer
+//             node
+//
+// Swaps the position of the node and the next one on the list, by changing
+// the links (not by copying the values), exactly like
+// dblList_Int__swapWithNext().  Unlike that one, this is done in place,
+// with six stores, rather than by a remove() and an addAfter().
+//
+// ERRORS:
+//   - Pointer is NULL, or the node (or the next one) is NIL/not in use.
+//     Print error.
+
+void dblArr_Int__swapWithNext(DblArr_Int *arr, uint32_t node)
+{
+	uint32_t prev, next, after;
+
+	if (!arr || !dblArr_Int__valid(arr, node) || arr->next[node] == DBLARR_INT_NIL) {
+		fprintf(stderr, "dblArr_Int__swapWithNext: The node, or the next object, are NIL.\n");
+		return;
+	}
+
+	/*    prev - node - next - after
+	 * => prev - next - node - after
+	 */
+	prev = arr->prev[node];
+	next = arr->next[node];
+	after = arr->next[next];
+
+	if (prev != DBLARR_INT_NIL)
+		arr->next[prev] = next;
+	arr->prev[next] = prev;
+	arr->next[next] = node;
+	arr->prev[node] = next;
+	arr->next[node] = after;
+	if (after != DBLARR_INT_NIL)
+		arr->prev[after] = node;
+}
+
+
+// ---------------- compact ---------------------------------
+// Parameters: 'this' pointer
+//             list (any node of the list)
+//
+// Moves the nodes of the list so that they are in order, in slots 0 through
+// N-1, and drops the free list.  Afterwards, arr->val[0..N) holds the values
+// of the list, in order, so that a scan over them is a simple loop over one
+// array, and a walk (next[i] == i+1) touches memory in order too.  Returns
+// the new index of the head, which is 0.
+//
+// Every node that is in use must be on this list: the old indices of all of
+// the nodes become meaningless.
+//
+// ERRORS:
+//   - Pointer is NULL, or the node is not in use.  Print error and return
+//     DBLARR_INT_NIL.
+//   - Some nodes in use are not on this list.  Print error and return
+//     DBLARR_INT_NIL; do *NOT* change anything.
+//   - malloc() fails.  Print error and return DBLARR_INT_NIL; do *NOT*
+//     change anything.
+
+uint32_t dblArr_Int__compact(DblArr_Int *arr, uint32_t list)
+{
+	uint32_t head, node, count, i;
+	int *val;
+
+	head = dblArr_Int__getHead(arr, list);
+	/* Errors should be handled in dblArr_Int__getHead */
+	if (head == DBLARR_INT_NIL)
+		return DBLARR_INT_NIL;
+
+	/* Count the list first; it must be the only one */
+	count = 0;
+	for (node = head; node != DBLARR_INT_NIL; node = arr->next[node])
+		count++;
+	if (count != arr->live) {
+		fprintf(stderr, "dblArr_Int__compact: Some nodes are not on the list.\n");
+		return DBLARR_INT_NIL;
+	}
+
+	/* Gather the values, in list order */
+	val = (int *)malloc(sizeof(int) * (size_t)arr->cap);
+	if (!val) {
+		perror("malloc");
+		return DBLARR_INT_NIL;
+	}
+	for (node = head, i = 0; node != DBLARR_INT_NIL; node = arr->next[node])
+		val[i++] = arr->val[node];
+	free(arr->val);
+	arr->val = val;
+
+	/* Rebuild the links; these loops are trivially vectorizable */
+	for (i = 0; i < count; i++) {
+		arr->prev[i] = i - 1;
+		arr->next[i] = i + 1;
+	}
+	arr->prev[0] = DBLARR_INT_NIL;
+	arr->next[count - 1] = DBLARR_INT_NIL;
+
+	arr->size = count;
+	arr->freeSlots = DBLARR_INT_NIL;
+
+	return 0;
+}
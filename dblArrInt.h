@@ -0,0 +1,55 @@
+/*
+ * dblArrInt.h
+ * Author:Qiwei Li
+ *
+ * DblArr_Int: an array-backed ("structure of arrays") version of DblList_Int.
+ *
+ * Instead of one heap object per node, every node lives in a slot of three
+ * parallel arrays, owned by one DblArr_Int: the values, the 'prev' indices
+ * and the 'next' indices.  A node is named by its 32-bit slot index, and
+ * DBLARR_INT_NIL plays the part of NULL.  Any number of lists may share one
+ * DblArr_Int, just like any number of lists may share the heap.
+ *
+ * The methods are the same as for DblList_Int (with the DblArr_Int as an
+ * extra first parameter), and they behave the same way, including errors.
+ */
+
+#ifndef __DBLARRINT_H__
+#define __DBLARRINT_H__
+
+#include <stdint.h>
+
+#define DBLARR_INT_NIL	0xffffffffu
+
+typedef struct DblArr_Int DblArr_Int;
+struct DblArr_Int {
+	int		*val;
+	uint32_t	*prev;
+	uint32_t	*next;
+	uint32_t	size;		/* slots [0, size) have been handed out */
+	uint32_t	cap;		/* length of each array */
+	uint32_t	freeSlots;	/* slots given back, chained by 'next' */
+	uint32_t	live;		/* slots in use */
+};
+
+DblArr_Int *dblArr_Int__alloc(uint32_t capacity);
+void dblArr_Int__free(DblArr_Int *arr);
+
+uint32_t dblArr_Int__allocNode(DblArr_Int *arr, int val);
+void dblArr_Int__freeNode(DblArr_Int *arr, uint32_t node);
+
+int dblArr_Int__getVal(DblArr_Int *arr, uint32_t node);
+uint32_t dblArr_Int__getNext(DblArr_Int *arr, uint32_t node);
+uint32_t dblArr_Int__getPrev(DblArr_Int *arr, uint32_t node);
+
+uint32_t dblArr_Int__getHead(DblArr_Int *arr, uint32_t node);
+uint32_t dblArr_Int__getTail(DblArr_Int *arr, uint32_t node);
+
+void dblArr_Int__addAfter(DblArr_Int *arr, uint32_t pos, uint32_t node);
+void dblArr_Int__addTail(DblArr_Int *arr, uint32_t list, int value);
+void dblArr_Int__remove(DblArr_Int *arr, uint32_t node);
+void dblArr_Int__swapWithNext(DblArr_Int *arr, uint32_t node);
+
+uint32_t dblArr_Int__compact(DblArr_Int *arr, uint32_t list);
+
+#endif
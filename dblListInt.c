@@ -5,8 +5,30 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DBLLIST_INT_X86	1
+#endif
 
 #include "dblListInt.h"
+#include "dblListIntExt.h"
+#include "listStats.h"
+
+/* Instrumentation (see listStats.h); all of this compiles away without
+ * -DLIST_STATS
+ */
+#ifdef LIST_STATS
+static __thread ListStats dblList_Int__stats;
+static __thread int dblList_Int__depth;
+static ListStats_Trace dblList_Int__trace;
+#endif
+
+#define DBLLIST_INT_STAT(field, n)	LIST_STATS_ADD(dblList_Int__stats, field, n)
+#define DBLLIST_INT_BEGIN()		LIST_STATS_BEGIN(dblList_Int__stats, dblList_Int__depth, statsMark)
+#define DBLLIST_INT_END(op) \
+	LIST_STATS_END(dblList_Int__stats, dblList_Int__depth, statsMark, dblList_Int__trace, op)
 
 // ------------- alloc() - Constructor ---------------
 // Parameters: int (value for the new node)
@@ -29,6 +51,7 @@ DblList_Int *dblList_Int__alloc(int val)
 		perror("malloc");
 		return NULL;
 	}
+	DBLLIST_INT_STAT(mallocs, 1);
 
 	/* Initialize the node */
 	node->val = val;
@@ -62,6 +85,7 @@ void dblList_Int__free(DblList_Int *node)
 
 	/* Free the node anyway */
 	free(node);
+	DBLLIST_INT_STAT(frees, 1);
 }
 
 
@@ -104,10 +128,14 @@ DblList_Int *dblList_Int__getHead(DblList_Int *node)
 		fprintf(stderr, "dblList_Int__getHead: The node is NULL.\n");
 		return NULL;
 	}
+	DBLLIST_INT_BEGIN();
 
 	/* Search toward the front of the list */
-	while (node->prev)
+	while (node->prev) {
 		node = node->prev;
+		DBLLIST_INT_STAT(nodesWalked, 1);
+	}
+	DBLLIST_INT_END("getHead");
 
 	return node;
 }
@@ -117,10 +145,14 @@ DblList_Int *dblList_Int__getTail(DblList_Int *node)
 		fprintf(stderr, "dblList_Int__addTail: The node is NULL.\n");
 		return NULL;
 	}
+	DBLLIST_INT_BEGIN();
 
 	/* Search toward the tail of the list */
-	while (node->next)
+	while (node->next) {
 		node = node->next;
+		DBLLIST_INT_STAT(nodesWalked, 1);
+	}
+	DBLLIST_INT_END("getTail");
 
 	return node;
 }
@@ -181,20 +213,101 @@ void dblList_Int__addTail(DblList_Int *list, int value)
 {
 	DblList_Int *tail, *node;
 
+	DBLLIST_INT_BEGIN();
+
 	/* Get tail of the list */
 	tail = dblList_Int__getTail(list);
 	/* Errors should be handled in dblList_Int__getTail */
-	if (!tail)
+	if (!tail) {
+		DBLLIST_INT_END("addTail");
 		return;
+	}
 
 	/* Alloc a new node */
 	node = dblList_Int__alloc(value);
 	/* Errors should be handled in dblList_Int__alloc */
-	if (!node)
+	if (node) {
+		/* Insert the node after tail of the list */
+		dblList_Int__addAfter(tail, node);
+	}
+	DBLLIST_INT_END("addTail");
+}
+
+/* Allocates 'n' nodes (n > 0) with the given values, and links them into a
+ * chain, first..last.  Returns -1 (having freed them again) if malloc()
+ * fails part way.
+ */
+static int dblList_Int__allocChain(const int *vals, int n, DblList_Int **first, DblList_Int **last)
+{
+	DblList_Int *node, *prev = NULL;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		node = (DblList_Int *)malloc(sizeof(DblList_Int));
+		if (!node) {
+			perror("malloc");
+			while (prev) {
+				node = prev->prev;
+				free(prev);
+				DBLLIST_INT_STAT(frees, 1);
+				prev = node;
+			}
+			return -1;
+		}
+		DBLLIST_INT_STAT(mallocs, 1);
+
+		node->val = vals[i];
+		node->prev = prev;
+		node->next = NULL;
+		if (prev)
+			prev->next = node;
+		else
+			*first = node;
+		prev = node;
+	}
+	*last = prev;
+
+	return 0;
+}
+
+// ---------------- addTailN --------------------------------
+// Parameters: 'this' pointer
+//             array of values
+//             n (the number of values)
+//
+// Equivalent to calling addTail() once for each value, in order - except
+// that the tail is only searched for once, and the new nodes are linked to
+// each other as they are allocated, and then linked onto the tail all at
+// once.  Adding N values one at a time costs O(N^2) (each addTail() walks
+// the whole list); this costs O(N), plus one walk to the tail.
+//
+// (Nodes which must be freed with dblList_Int__free() have to be
+// malloc()ed one at a time; see dblPool_Int__addTailN() for the version
+// which allocates a whole batch at once.)
+//
+// ERRORS:
+//   - Pointer is NULL, or n < 0.  Print error.
+//   - malloc() fails.  Print error; the list is not changed.
+
+void dblList_Int__addTailN(DblList_Int *list, const int *vals, int n)
+{
+	DblList_Int *tail, *first, *last;
+
+	if (!vals || n < 0) {
+		fprintf(stderr, "dblList_Int__addTailN: The values are NULL, or n is negative.\n");
 		return;
+	}
+	DBLLIST_INT_BEGIN();
 
-	/* Insert the node after tail of the list */
-	dblList_Int__addAfter(tail, node);
+	/* Get tail of the list */
+	tail = dblList_Int__getTail(list);
+	/* Errors should be handled in dblList_Int__getTail */
+	if (tail && n && dblList_Int__allocChain(vals, n, &first, &last) == 0) {
+		/* Splice the whole chain on at once */
+		tail->next = first;
+		first->prev = tail;
+	}
+	DBLLIST_INT_END("addTailN");
 }
 
 // ---------------- remove ---------------------------------
@@ -269,3 +382,1236 @@ void dblList_Int__swapWithNext(DblList_Int *node)
 	/* Add this node after the original next node */
 	dblList_Int__addAfter(next, node);
 }
+
+
+// ---------------- DblPool_Int (node pool) -----------------
+//
+// An optional pool which hands out DblList_Int nodes from large contiguous
+// slabs, instead of calling malloc() once per node.  Nodes which are given
+// back to the pool are kept on a free list (chained through their 'next'
+// pointers), and are reused before the pool asks for another slab.  Each
+// slab is twice as large as the one before it (up to a limit), so a pool
+// with N nodes only ever has O(log N) + N/DBLPOOL_INT_SLAB_MAX slabs.
+//
+// Freeing the pool releases *EVERY* node that was ever allocated from it,
+// one slab at a time - there is no need to remove and free each node first.
+//
+// NOTE: Nodes from a pool must *NOT* be passed to dblList_Int__free(); give
+//       them back with dblPool_Int__freeNode() (or just free the pool).  All
+//       of the other node methods work on them as usual.
+
+#define DBLPOOL_INT_SLAB_MIN	64
+#define DBLPOOL_INT_SLAB_MAX	65536
+
+typedef struct DblList_Int_Slab DblList_Int_Slab;
+struct DblList_Int_Slab {
+	DblList_Int_Slab	*next;
+	DblList_Int		nodes[];
+};
+
+struct DblList_Int_Pool {
+	DblList_Int_Slab	*slabs;		/* newest slab first */
+	int			used;		/* nodes handed out from slabs->nodes */
+	int			size;		/* capacity of slabs->nodes */
+	DblList_Int		*freeNodes;
+};
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None
+//
+// Allocates a new, empty pool.  No slabs are allocated until the first node
+// is requested.
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+DblPool_Int *dblPool_Int__alloc()
+{
+	DblPool_Int *pool;
+
+	pool = (DblPool_Int *)malloc(sizeof(DblPool_Int));
+	if (!pool) {
+		perror("malloc");
+		return NULL;
+	}
+	DBLLIST_INT_STAT(mallocs, 1);
+
+	pool->slabs = NULL;
+	pool->used = 0;
+	pool->size = 0;
+	pool->freeNodes = NULL;
+
+	return pool;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer (for the pool)
+//
+// Frees the pool, and every node which was allocated from it, in O(slabs).
+// The nodes may still be linked into lists; those lists simply go away too.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void dblPool_Int__free(DblPool_Int *pool)
+{
+	DblList_Int_Slab *slab, *next;
+
+	if (!pool) {
+		fprintf(stderr, "dblPool_Int__free: The pool is NULL.\n");
+		return;
+	}
+
+	for (slab = pool->slabs; slab; slab = next) {
+		next = slab->next;
+		free(slab);
+		DBLLIST_INT_STAT(frees, 1);
+	}
+	free(pool);
+	DBLLIST_INT_STAT(frees, 1);
+}
+
+// ---------------- allocNode -------------------------------
+// Parameters: 'this' pointer (for the pool)
+//             int (value for the new node)
+//
+// Equivalent to dblList_Int__alloc(), except that the node comes from the
+// pool: a node from the free list if there is one, otherwise the next unused
+// node of the newest slab.  A new slab is only malloc()ed when the current
+// one is full.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return NULL.
+//   - malloc() fails.  Print error and return NULL.
+
+/* Adds a new slab, which holds at least 'min' nodes (and, normally, twice
+ * as many as the one before it).  Returns -1 if malloc() fails.
+ */
+static int dblPool_Int__addSlab(DblPool_Int *pool, int min)
+{
+	DblList_Int_Slab *slab;
+	int size;
+
+	size = pool->size ? pool->size * 2 : DBLPOOL_INT_SLAB_MIN;
+	if (size > DBLPOOL_INT_SLAB_MAX)
+		size = DBLPOOL_INT_SLAB_MAX;
+	if (size < min)
+		size = min;
+
+	slab = (DblList_Int_Slab *)malloc(sizeof(DblList_Int_Slab) + sizeof(DblList_Int) * size);
+	if (!slab) {
+		perror("malloc");
+		return -1;
+	}
+	DBLLIST_INT_STAT(mallocs, 1);
+
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	pool->used = 0;
+	pool->size = size;
+
+	return 0;
+}
+
+DblList_Int *dblPool_Int__allocNode(DblPool_Int *pool, int val)
+{
+	DblList_Int *node;
+
+	if (!pool) {
+		fprintf(stderr, "dblPool_Int__allocNode: The pool is NULL.\n");
+		return NULL;
+	}
+
+	if (pool->freeNodes) {
+		/* Reuse a node that was given back */
+		node = pool->freeNodes;
+		pool->freeNodes = node->next;
+	} else {
+		/* The current slab is full; add a bigger one */
+		if (pool->used == pool->size && dblPool_Int__addSlab(pool, 0) < 0)
+			return NULL;
+
+		node = &pool->slabs->nodes[pool->used++];
+	}
+
+	/* Initialize the node */
+	node->val = val;
+	node->prev = NULL;
+	node->next = NULL;
+
+	return node;
+}
+
+// ---------------- freeNode --------------------------------
+// Parameters: 'this' pointer (for the pool)
+//             node (which must have come from this pool)
+//
+// Equivalent to dblList_Int__free(), except that the node is put on the
+// pool's free list, instead of being given back to free().
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error.
+//   - The node has non-NULL next or prev pointers.  Print error, but still
+//     give the node back before returning.
+
+void dblPool_Int__freeNode(DblPool_Int *pool, DblList_Int *node)
+{
+	if (!pool || !node) {
+		fprintf(stderr, "dblPool_Int__freeNode: The pool or node is NULL.\n");
+		return;
+	}
+
+	/* Sanity check */
+	if (node->prev || node->next)
+		fprintf(stderr, "dblPool_Int__freeNode: The existing node has non-NULL next or prev pointers.\n");
+
+	/* Give the node back anyway */
+	node->prev = NULL;
+	node->next = pool->freeNodes;
+	pool->freeNodes = node;
+}
+
+/* Like dblList_Int__allocChain(), but the nodes are consecutive nodes of
+ * one slab: whatever is left of the current slab, and then (if that is not
+ * enough) one new slab, big enough for all of the rest.
+ */
+static int dblPool_Int__allocChain(DblPool_Int *pool, const int *vals, int n,
+                                   DblList_Int **first, DblList_Int **last)
+{
+	DblList_Int *nodes, *prev = NULL;
+	int i, k, take;
+
+	for (i = 0; i < n; i += take) {
+		if (pool->used == pool->size && dblPool_Int__addSlab(pool, n - i) < 0)
+			return -1;	/* the nodes taken so far just stay in the slab */
+
+		take = pool->size - pool->used;
+		if (take > n - i)
+			take = n - i;
+		nodes = &pool->slabs->nodes[pool->used];
+		pool->used += take;
+
+		for (k = 0; k < take; k++) {
+			nodes[k].val = vals[i + k];
+			nodes[k].prev = k ? &nodes[k - 1] : prev;
+			nodes[k].next = &nodes[k + 1];
+		}
+		if (prev)
+			prev->next = &nodes[0];
+		else
+			*first = &nodes[0];
+		prev = &nodes[take - 1];
+	}
+	prev->next = NULL;
+	*last = prev;
+
+	return 0;
+}
+
+// ---------------- addTailN --------------------------------
+// Parameters: 'this' pointer (for the pool)
+//             a node of the list
+//             array of values
+//             n (the number of values)
+//
+// Equivalent to dblList_Int__addTailN(), except that the new nodes come
+// from the pool - as one block of consecutive nodes (at most two: the rest
+// of the current slab, and one new slab for everything else), rather than
+// one allocation per node.  Nodes on the pool's free list are not reused.
+//
+// ERRORS:
+//   - Either pointer is NULL, or n < 0.  Print error.
+//   - malloc() fails.  Print error; the list is not changed.
+
+void dblPool_Int__addTailN(DblPool_Int *pool, DblList_Int *list, const int *vals, int n)
+{
+	DblList_Int *tail, *first, *last;
+
+	if (!pool || !vals || n < 0) {
+		fprintf(stderr, "dblPool_Int__addTailN: The pool or values are NULL, or n is negative.\n");
+		return;
+	}
+	DBLLIST_INT_BEGIN();
+
+	/* Get tail of the list */
+	tail = dblList_Int__getTail(list);
+	/* Errors should be handled in dblList_Int__getTail */
+	if (tail && n && dblPool_Int__allocChain(pool, vals, n, &first, &last) == 0) {
+		/* Splice the whole chain on at once */
+		tail->next = first;
+		first->prev = tail;
+	}
+	DBLLIST_INT_END("addTailN");
+}
+
+
+// ---------------- bulk queries (various) ------------------
+//
+// Queries which look at every value from a given node to the tail of its
+// list: getMin(), getMax(), sum(), countRange() and findVal().  (Pass the
+// head, to query the whole list.)
+//
+// The values are gathered, DBLLIST_INT_BLOCK at a time, into a small buffer
+// on the stack; only the gather has to chase 'next' pointers.  Each block is
+// then handed to a kernel: an AVX2 or SSE4.1 one if the CPU supports it
+// (checked once, at the first query), or a plain C one otherwise.  All of
+// the kernels do exact integer arithmetic, so they give the same results.
+
+#define DBLLIST_INT_BLOCK	256
+
+typedef struct DblList_Int_Kernels DblList_Int_Kernels;
+struct DblList_Int_Kernels {
+	int		(*min)(const int *vals, int n, int min);
+	int		(*max)(const int *vals, int n, int max);
+	long long	(*sum)(const int *vals, int n);
+	int		(*outside)(const int *vals, int n, int lo, int hi);
+	int		(*find)(const int *vals, int n, int val);
+};
+
+/* Copies up to DBLLIST_INT_BLOCK values into 'vals', starting at *pos, and
+ * moves *pos past them.  Returns the number copied.
+ */
+static int dblList_Int__gather(DblList_Int **pos, int *vals)
+{
+	DblList_Int *node = *pos;
+	int n = 0;
+
+	while (node && n < DBLLIST_INT_BLOCK) {
+		vals[n++] = node->val;
+		node = node->next;
+	}
+	*pos = node;
+	DBLLIST_INT_STAT(nodesWalked, n);
+
+	return n;
+}
+
+/* Plain C kernels */
+
+static int dblList_Int__minC(const int *vals, int n, int min)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (vals[i] < min)
+			min = vals[i];
+	}
+	return min;
+}
+static int dblList_Int__maxC(const int *vals, int n, int max)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (vals[i] > max)
+			max = vals[i];
+	}
+	return max;
+}
+static long long dblList_Int__sumC(const int *vals, int n)
+{
+	long long sum = 0;
+	int i;
+
+	for (i = 0; i < n; i++)
+		sum += vals[i];
+	return sum;
+}
+static int dblList_Int__outsideC(const int *vals, int n, int lo, int hi)
+{
+	int count = 0, i;
+
+	for (i = 0; i < n; i++)
+		count += vals[i] < lo || vals[i] > hi;
+	return count;
+}
+static int dblList_Int__findC(const int *vals, int n, int val)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (vals[i] == val)
+			return i;
+	}
+	return -1;
+}
+
+static const DblList_Int_Kernels dblList_Int__kernelsC = {
+	dblList_Int__minC, dblList_Int__maxC, dblList_Int__sumC,
+	dblList_Int__outsideC, dblList_Int__findC
+};
+
+#ifdef DBLLIST_INT_X86
+
+/* SSE4.1 kernels: 4 values at a time; the leftovers go to the C kernels */
+
+__attribute__((target("sse4.1")))
+static int dblList_Int__minSSE(const int *vals, int n, int min)
+{
+	__m128i m = _mm_set1_epi32(min);
+	int lanes[4], i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+		m = _mm_min_epi32(m, _mm_loadu_si128((const __m128i *)(vals + i)));
+	_mm_storeu_si128((__m128i *)lanes, m);
+
+	return dblList_Int__minC(vals + i, n - i, dblList_Int__minC(lanes, 4, min));
+}
+__attribute__((target("sse4.1")))
+static int dblList_Int__maxSSE(const int *vals, int n, int max)
+{
+	__m128i m = _mm_set1_epi32(max);
+	int lanes[4], i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+		m = _mm_max_epi32(m, _mm_loadu_si128((const __m128i *)(vals + i)));
+	_mm_storeu_si128((__m128i *)lanes, m);
+
+	return dblList_Int__maxC(vals + i, n - i, dblList_Int__maxC(lanes, 4, max));
+}
+__attribute__((target("sse4.1")))
+static long long dblList_Int__sumSSE(const int *vals, int n)
+{
+	__m128i acc = _mm_setzero_si128();
+	long long lanes[2];
+	int i;
+
+	/* Widen to 64 bits before adding, so that nothing can overflow */
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(vals + i));
+
+		acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+		acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+	}
+	_mm_storeu_si128((__m128i *)lanes, acc);
+
+	return lanes[0] + lanes[1] + dblList_Int__sumC(vals + i, n - i);
+}
+__attribute__((target("sse4.1")))
+static int dblList_Int__outsideSSE(const int *vals, int n, int lo, int hi)
+{
+	__m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+	__m128i acc = _mm_setzero_si128();
+	int lanes[4], i;
+
+	/* Each lane of a compare is -1 (true) or 0; subtracting counts them */
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(vals + i));
+
+		acc = _mm_sub_epi32(acc, _mm_or_si128(_mm_cmpgt_epi32(vlo, v), _mm_cmpgt_epi32(v, vhi)));
+	}
+	_mm_storeu_si128((__m128i *)lanes, acc);
+
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+	       dblList_Int__outsideC(vals + i, n - i, lo, hi);
+}
+__attribute__((target("sse4.1")))
+static int dblList_Int__findSSE(const int *vals, int n, int val)
+{
+	__m128i vval = _mm_set1_epi32(val);
+	int i, mask, found;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		mask = _mm_movemask_ps(_mm_castsi128_ps(
+		       _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(vals + i)), vval)));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	found = dblList_Int__findC(vals + i, n - i, val);
+	return found < 0 ? -1 : i + found;
+}
+
+static const DblList_Int_Kernels dblList_Int__kernelsSSE = {
+	dblList_Int__minSSE, dblList_Int__maxSSE, dblList_Int__sumSSE,
+	dblList_Int__outsideSSE, dblList_Int__findSSE
+};
+
+/* AVX2 kernels: 8 values at a time */
+
+__attribute__((target("avx2")))
+static int dblList_Int__minAVX2(const int *vals, int n, int min)
+{
+	__m256i m = _mm256_set1_epi32(min);
+	int lanes[8], i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		m = _mm256_min_epi32(m, _mm256_loadu_si256((const __m256i *)(vals + i)));
+	_mm256_storeu_si256((__m256i *)lanes, m);
+
+	return dblList_Int__minC(vals + i, n - i, dblList_Int__minC(lanes, 8, min));
+}
+__attribute__((target("avx2")))
+static int dblList_Int__maxAVX2(const int *vals, int n, int max)
+{
+	__m256i m = _mm256_set1_epi32(max);
+	int lanes[8], i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+		m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i *)(vals + i)));
+	_mm256_storeu_si256((__m256i *)lanes, m);
+
+	return dblList_Int__maxC(vals + i, n - i, dblList_Int__maxC(lanes, 8, max));
+}
+__attribute__((target("avx2")))
+static long long dblList_Int__sumAVX2(const int *vals, int n)
+{
+	__m256i acc = _mm256_setzero_si256();
+	long long lanes[4];
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(vals + i));
+
+		acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+		acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+	}
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + dblList_Int__sumC(vals + i, n - i);
+}
+__attribute__((target("avx2")))
+static int dblList_Int__outsideAVX2(const int *vals, int n, int lo, int hi)
+{
+	__m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+	__m256i acc = _mm256_setzero_si256();
+	int lanes[8], i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(vals + i));
+
+		acc = _mm256_sub_epi32(acc, _mm256_or_si256(_mm256_cmpgt_epi32(vlo, v),
+		                                             _mm256_cmpgt_epi32(v, vhi)));
+	}
+	_mm256_storeu_si256((__m256i *)lanes, acc);
+
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+	       lanes[4] + lanes[5] + lanes[6] + lanes[7] +
+	       dblList_Int__outsideC(vals + i, n - i, lo, hi);
+}
+__attribute__((target("avx2")))
+static int dblList_Int__findAVX2(const int *vals, int n, int val)
+{
+	__m256i vval = _mm256_set1_epi32(val);
+	int i, mask, found;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+		       _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(vals + i)), vval)));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+
+	found = dblList_Int__findC(vals + i, n - i, val);
+	return found < 0 ? -1 : i + found;
+}
+
+static const DblList_Int_Kernels dblList_Int__kernelsAVX2 = {
+	dblList_Int__minAVX2, dblList_Int__maxAVX2, dblList_Int__sumAVX2,
+	dblList_Int__outsideAVX2, dblList_Int__findAVX2
+};
+
+#endif	/* DBLLIST_INT_X86 */
+
+/* Picks the best kernels that this CPU can run (once) */
+static const DblList_Int_Kernels *dblList_Int__kernels()
+{
+	static const DblList_Int_Kernels *kernels;
+
+	if (!kernels) {
+		kernels = &dblList_Int__kernelsC;
+#ifdef DBLLIST_INT_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			kernels = &dblList_Int__kernelsAVX2;
+		else if (__builtin_cpu_supports("sse4.1"))
+			kernels = &dblList_Int__kernelsSSE;
+#endif
+	}
+
+	return kernels;
+}
+
+// ---------------- getMin/getMax/sum -----------------------
+// Parameters: 'this' pointer
+//
+// Returns the smallest value, the largest value, or the sum of the values,
+// from the 'this' node to the tail.  The sum is a long long, so that it
+// can't overflow.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return 0.
+
+int dblList_Int__getMin(DblList_Int *node)
+{
+	const DblList_Int_Kernels *k = dblList_Int__kernels();
+	int vals[DBLLIST_INT_BLOCK], n, min = INT_MAX;
+
+	if (!node) {
+		fprintf(stderr, "dblList_Int__getMin: The node is NULL.\n");
+		return 0;
+	}
+	DBLLIST_INT_BEGIN();
+
+	while ((n = dblList_Int__gather(&node, vals))) {
+		min = k->min(vals, n, min);
+		DBLLIST_INT_STAT(compares, n);
+	}
+	DBLLIST_INT_END("getMin");
+
+	return min;
+}
+int dblList_Int__getMax(DblList_Int *node)
+{
+	const DblList_Int_Kernels *k = dblList_Int__kernels();
+	int vals[DBLLIST_INT_BLOCK], n, max = INT_MIN;
+
+	if (!node) {
+		fprintf(stderr, "dblList_Int__getMax: The node is NULL.\n");
+		return 0;
+	}
+	DBLLIST_INT_BEGIN();
+
+	while ((n = dblList_Int__gather(&node, vals))) {
+		max = k->max(vals, n, max);
+		DBLLIST_INT_STAT(compares, n);
+	}
+	DBLLIST_INT_END("getMax");
+
+	return max;
+}
+long long dblList_Int__sum(DblList_Int *node)
+{
+	const DblList_Int_Kernels *k = dblList_Int__kernels();
+	int vals[DBLLIST_INT_BLOCK], n;
+	long long sum = 0;
+
+	if (!node) {
+		fprintf(stderr, "dblList_Int__sum: The node is NULL.\n");
+		return 0;
+	}
+	DBLLIST_INT_BEGIN();
+
+	while ((n = dblList_Int__gather(&node, vals)))
+		sum += k->sum(vals, n);
+	DBLLIST_INT_END("sum");
+
+	return sum;
+}
+
+// ---------------- countRange ------------------------------
+// Parameters: 'this' pointer
+//             lo, hi (the range, inclusive at both ends)
+//
+// Counts the values, from the 'this' node to the tail, which are in the
+// range [lo, hi].  Use INT_MIN or INT_MAX for an open-ended range (so
+// "less than x" is countRange(list, INT_MIN, x-1)), and lo==hi to count the
+// values equal to one value.  Calling it once per bucket builds a histogram.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return -1.
+//   - lo > hi.  Return 0 (the range is empty).
+
+int dblList_Int__countRange(DblList_Int *node, int lo, int hi)
+{
+	const DblList_Int_Kernels *k = dblList_Int__kernels();
+	int vals[DBLLIST_INT_BLOCK], n, count = 0;
+
+	if (!node) {
+		fprintf(stderr, "dblList_Int__countRange: The node is NULL.\n");
+		return -1;
+	}
+	if (lo > hi)
+		return 0;
+	DBLLIST_INT_BEGIN();
+
+	while ((n = dblList_Int__gather(&node, vals))) {
+		count += n - k->outside(vals, n, lo, hi);
+		DBLLIST_INT_STAT(compares, 2 * n);
+	}
+	DBLLIST_INT_END("countRange");
+
+	return count;
+}
+
+// ---------------- findVal ---------------------------------
+// Parameters: 'this' pointer
+//             val
+//
+// Returns the first node, from the 'this' node toward the tail, whose value
+// equals 'val'; or NULL if there is none.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return NULL.
+
+DblList_Int *dblList_Int__findVal(DblList_Int *node, int val)
+{
+	const DblList_Int_Kernels *k = dblList_Int__kernels();
+	int vals[DBLLIST_INT_BLOCK], n, found;
+	DblList_Int *start;
+
+	if (!node) {
+		fprintf(stderr, "dblList_Int__findVal: The node is NULL.\n");
+		return NULL;
+	}
+	DBLLIST_INT_BEGIN();
+
+	for (;;) {
+		start = node;
+		n = dblList_Int__gather(&node, vals);
+		if (!n) {
+			DBLLIST_INT_END("findVal");
+			return NULL;
+		}
+
+		found = k->find(vals, n, val);
+		if (found >= 0)
+			break;
+		DBLLIST_INT_STAT(compares, n);
+	}
+	DBLLIST_INT_STAT(compares, found + 1);
+
+	/* Walk back to the node that matched, from the start of its block */
+	DBLLIST_INT_STAT(nodesWalked, found);
+	while (found--)
+		start = start->next;
+	DBLLIST_INT_END("findVal");
+	return start;
+}
+
+
+// ---------------- DblListHdr_Int (list header) ------------
+//
+// An optional "header" object, which owns one list, and keeps track of its
+// head, tail and length - so that pushing or popping at either end, and
+// splicing in a whole list, are all O(1), instead of walking the chain.
+//
+// The nodes are ordinary DblList_Int nodes, and all of the per-node methods
+// still work on them.  The header checks its head and tail each time it
+// uses them, and follows the chain if a node has been added beyond them (by
+// addAfter(), addTail() or swapWithNext() on a node, say).  The length is
+// kept up to date by the header methods; after adding or removing nodes with
+// the per-node methods, call recount().  A node which is the head or tail
+// must only be removed with the header's remove().
+//
+// Freeing the header frees every node on the list.  A header made with
+// allocPool() takes its nodes from a DblPool_Int (and frees them back to
+// it) - so every node added to it some other way must come from that pool
+// too; dblList_Int__addTail() on its nodes is not allowed.
+
+struct DblList_Int_Header {
+	DblList_Int	*head;
+	DblList_Int	*tail;
+	int		count;
+	DblPool_Int	*pool;
+};
+
+static DblList_Int *dblListHdr_Int__allocNode(DblListHdr_Int *hdr, int val)
+{
+	if (hdr->pool)
+		return dblPool_Int__allocNode(hdr->pool, val);
+	return dblList_Int__alloc(val);
+}
+
+static void dblListHdr_Int__freeNode(DblListHdr_Int *hdr, DblList_Int *node)
+{
+	if (hdr->pool)
+		dblPool_Int__freeNode(hdr->pool, node);
+	else {
+		free(node);
+		DBLLIST_INT_STAT(frees, 1);
+	}
+}
+
+/* Catches up with nodes that were added beyond the head or tail by the
+ * per-node methods
+ */
+static void dblListHdr_Int__sync(DblListHdr_Int *hdr)
+{
+	if (hdr->head) {
+		while (hdr->head->prev) {
+			hdr->head = hdr->head->prev;
+			DBLLIST_INT_STAT(nodesWalked, 1);
+		}
+		while (hdr->tail->next) {
+			hdr->tail = hdr->tail->next;
+			DBLLIST_INT_STAT(nodesWalked, 1);
+		}
+	}
+}
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None (allocPool(): the pool to take nodes from)
+//
+// Allocates a new header, which holds an empty list.
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+//   - allocPool(): The pool is NULL.  Print error and return NULL.
+
+DblListHdr_Int *dblListHdr_Int__alloc()
+{
+	DblListHdr_Int *hdr;
+
+	hdr = (DblListHdr_Int *)malloc(sizeof(DblListHdr_Int));
+	if (!hdr) {
+		perror("malloc");
+		return NULL;
+	}
+	DBLLIST_INT_STAT(mallocs, 1);
+
+	hdr->head = NULL;
+	hdr->tail = NULL;
+	hdr->count = 0;
+	hdr->pool = NULL;
+
+	return hdr;
+}
+DblListHdr_Int *dblListHdr_Int__allocPool(DblPool_Int *pool)
+{
+	DblListHdr_Int *hdr;
+
+	if (!pool) {
+		fprintf(stderr, "dblListHdr_Int__allocPool: The pool is NULL.\n");
+		return NULL;
+	}
+
+	hdr = dblListHdr_Int__alloc();
+	/* Errors should be handled in dblListHdr_Int__alloc */
+	if (hdr)
+		hdr->pool = pool;
+
+	return hdr;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer (for the header)
+//
+// Frees the header, and every node on its list, in one pass (the nodes are
+// not unlinked one at a time first).
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void dblListHdr_Int__free(DblListHdr_Int *hdr)
+{
+	DblList_Int *node, *next;
+
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__free: The header is NULL.\n");
+		return;
+	}
+	DBLLIST_INT_BEGIN();
+
+	dblListHdr_Int__sync(hdr);
+	for (node = hdr->head; node; node = next) {
+		next = node->next;
+		node->prev = NULL;
+		node->next = NULL;
+		dblListHdr_Int__freeNode(hdr, node);
+	}
+	free(hdr);
+	DBLLIST_INT_STAT(frees, 1);
+	DBLLIST_INT_END("free");
+}
+
+// ---------------- gettors (various) -----------------------
+// Parameters: 'this' pointer (for the header)
+//
+// Return the head or tail node (NULL if the list is empty), or the length
+// of the list, in O(1).
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return NULL (count(): -1).
+
+DblList_Int *dblListHdr_Int__getHead(DblListHdr_Int *hdr)
+{
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__getHead: The header is NULL.\n");
+		return NULL;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	return hdr->head;
+}
+DblList_Int *dblListHdr_Int__getTail(DblListHdr_Int *hdr)
+{
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__getTail: The header is NULL.\n");
+		return NULL;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	return hdr->tail;
+}
+int dblListHdr_Int__count(DblListHdr_Int *hdr)
+{
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__count: The header is NULL.\n");
+		return -1;
+	}
+
+	return hdr->count;
+}
+
+// ---------------- recount ---------------------------------
+// Parameters: 'this' pointer (for the header)
+//
+// Walks the list, and updates the length kept in the header.  Only needed
+// after nodes were added or removed with the per-node methods.  Returns the
+// length.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return -1.
+
+int dblListHdr_Int__recount(DblListHdr_Int *hdr)
+{
+	DblList_Int *node;
+
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__recount: The header is NULL.\n");
+		return -1;
+	}
+
+	DBLLIST_INT_BEGIN();
+	dblListHdr_Int__sync(hdr);
+	hdr->count = 0;
+	for (node = hdr->head; node; node = node->next)
+		hdr->count++;
+	DBLLIST_INT_STAT(nodesWalked, hdr->count);
+	DBLLIST_INT_END("recount");
+
+	return hdr->count;
+}
+
+// ---------------- pushHead/pushTail -----------------------
+// Parameters: 'this' pointer (for the header)
+//             *value*
+//
+// Allocates a new node (using the value given), and adds it at the head or
+// tail of the list, in O(1).
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+//   - malloc() fails.  Print error; the list is not changed.
+
+void dblListHdr_Int__pushHead(DblListHdr_Int *hdr, int value)
+{
+	DblList_Int *node;
+
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__pushHead: The header is NULL.\n");
+		return;
+	}
+
+	node = dblListHdr_Int__allocNode(hdr, value);
+	/* Errors should be handled in dblList_Int__alloc/dblPool_Int__allocNode */
+	if (!node)
+		return;
+
+	dblListHdr_Int__sync(hdr);
+	node->next = hdr->head;
+	if (hdr->head)
+		hdr->head->prev = node;
+	else
+		hdr->tail = node;
+	hdr->head = node;
+	hdr->count++;
+}
+void dblListHdr_Int__pushTail(DblListHdr_Int *hdr, int value)
+{
+	DblList_Int *node;
+
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__pushTail: The header is NULL.\n");
+		return;
+	}
+
+	node = dblListHdr_Int__allocNode(hdr, value);
+	/* Errors should be handled in dblList_Int__alloc/dblPool_Int__allocNode */
+	if (!node)
+		return;
+
+	dblListHdr_Int__sync(hdr);
+	node->prev = hdr->tail;
+	if (hdr->tail)
+		hdr->tail->next = node;
+	else
+		hdr->head = node;
+	hdr->tail = node;
+	hdr->count++;
+}
+
+// ---------------- pushTailN -------------------------------
+// Parameters: 'this' pointer (for the header)
+//             array of values
+//             n (the number of values)
+//
+// Equivalent to calling pushTail() once for each value, in order, but the
+// nodes are linked to each other as they are allocated, and spliced onto
+// the tail all at once.  In a header made with allocPool(), the nodes are
+// allocated as one block (see dblPool_Int__addTailN()).
+//
+// ERRORS:
+//   - Pointer is NULL, or n < 0.  Print error.
+//   - malloc() fails.  Print error; the list is not changed.
+
+void dblListHdr_Int__pushTailN(DblListHdr_Int *hdr, const int *vals, int n)
+{
+	DblList_Int *first, *last;
+	int err;
+
+	if (!hdr || !vals || n < 0) {
+		fprintf(stderr, "dblListHdr_Int__pushTailN: The header or values are NULL, or n is negative.\n");
+		return;
+	}
+	if (!n)
+		return;
+
+	if (hdr->pool)
+		err = dblPool_Int__allocChain(hdr->pool, vals, n, &first, &last);
+	else
+		err = dblList_Int__allocChain(vals, n, &first, &last);
+	if (err < 0)
+		return;
+
+	/* Splice the whole chain on at once */
+	dblListHdr_Int__sync(hdr);
+	first->prev = hdr->tail;
+	if (hdr->tail)
+		hdr->tail->next = first;
+	else
+		hdr->head = first;
+	hdr->tail = last;
+	hdr->count += n;
+}
+
+// ---------------- popHead/popTail -------------------------
+// Parameters: 'this' pointer (for the header)
+//
+// Removes the node at the head or tail of the list, frees it, and returns
+// its value, in O(1).
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return 0.
+//   - The list is empty.  Print error and return 0.
+
+int dblListHdr_Int__popHead(DblListHdr_Int *hdr)
+{
+	DblList_Int *node;
+	int val;
+
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__popHead: The header is NULL.\n");
+		return 0;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	node = hdr->head;
+	if (!node) {
+		fprintf(stderr, "dblListHdr_Int__popHead: The list is empty.\n");
+		return 0;
+	}
+
+	hdr->head = node->next;
+	if (hdr->head)
+		hdr->head->prev = NULL;
+	else
+		hdr->tail = NULL;
+	hdr->count--;
+
+	val = node->val;
+	node->next = NULL;
+	dblListHdr_Int__freeNode(hdr, node);
+	return val;
+}
+int dblListHdr_Int__popTail(DblListHdr_Int *hdr)
+{
+	DblList_Int *node;
+	int val;
+
+	if (!hdr) {
+		fprintf(stderr, "dblListHdr_Int__popTail: The header is NULL.\n");
+		return 0;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	node = hdr->tail;
+	if (!node) {
+		fprintf(stderr, "dblListHdr_Int__popTail: The list is empty.\n");
+		return 0;
+	}
+
+	hdr->tail = node->prev;
+	if (hdr->tail)
+		hdr->tail->next = NULL;
+	else
+		hdr->head = NULL;
+	hdr->count--;
+
+	val = node->val;
+	node->prev = NULL;
+	dblListHdr_Int__freeNode(hdr, node);
+	return val;
+}
+
+// ---------------- addAfter/remove -------------------------
+// Parameters: 'this' pointer (for the header)
+//             pos (addAfter() only; a node on this list, or NULL)
+//             node
+//
+// Just like dblList_Int__addAfter() and dblList_Int__remove(), but they
+// also keep the header's head, tail and length up to date.  addAfter() with
+// a NULL 'pos' adds the node at the head.  remove() unlinks the node, but
+// does not free it: it no longer belongs to the header.
+//
+// ERRORS:
+//   - The header or node is NULL.  Print error.
+//   - addAfter(): the node is already on a list.  Print error and return.
+
+void dblListHdr_Int__addAfter(DblListHdr_Int *hdr, DblList_Int *pos, DblList_Int *node)
+{
+	if (!hdr || !node) {
+		fprintf(stderr, "dblListHdr_Int__addAfter: The header or node is NULL.\n");
+		return;
+	}
+
+	/* Sanity check */
+	if (node->prev || node->next) {
+		fprintf(stderr, "dblListHdr_Int__addAfter: The node is already on a list.\n");
+		return;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	if (!pos) {
+		node->next = hdr->head;
+		if (hdr->head)
+			hdr->head->prev = node;
+		else
+			hdr->tail = node;
+		hdr->head = node;
+	} else {
+		dblList_Int__addAfter(pos, node);
+		if (pos == hdr->tail)
+			hdr->tail = node;
+	}
+	hdr->count++;
+}
+void dblListHdr_Int__remove(DblListHdr_Int *hdr, DblList_Int *node)
+{
+	if (!hdr || !node) {
+		fprintf(stderr, "dblListHdr_Int__remove: The header or node is NULL.\n");
+		return;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	if (node == hdr->head)
+		hdr->head = node->next;
+	if (node == hdr->tail)
+		hdr->tail = node->prev;
+
+	/* A list of one node: remove() would complain that it isn't on a list */
+	if (node->prev || node->next)
+		dblList_Int__remove(node);
+	hdr->count--;
+}
+
+// ---------------- splice ----------------------------------
+// Parameters: 'this' pointer (for the header)
+//             pos (a node on this list, or NULL)
+//             another header
+//
+// Moves every node of the other list into this one, right after 'pos' (or
+// at the head, if 'pos' is NULL), in O(1).  The other list is left empty;
+// it is not freed.  Both headers must take their nodes from the same place
+// (malloc(), or the same pool), since the nodes change owners.
+//
+// ERRORS:
+//   - Either header is NULL.  Print error.
+//   - The headers use different pools.  Print error; nothing is moved.
+
+void dblListHdr_Int__splice(DblListHdr_Int *hdr, DblList_Int *pos, DblListHdr_Int *other)
+{
+	DblList_Int *first, *last, *after;
+
+	if (!hdr || !other) {
+		fprintf(stderr, "dblListHdr_Int__splice: The header(s) is NULL.\n");
+		return;
+	}
+	if (hdr->pool != other->pool) {
+		fprintf(stderr, "dblListHdr_Int__splice: The headers use different pools.\n");
+		return;
+	}
+
+	dblListHdr_Int__sync(hdr);
+	dblListHdr_Int__sync(other);
+	first = other->head;
+	last = other->tail;
+	if (!first || hdr == other)
+		return;
+
+	after = pos ? pos->next : hdr->head;
+	first->prev = pos;
+	if (pos)
+		pos->next = first;
+	else
+		hdr->head = first;
+	last->next = after;
+	if (after)
+		after->prev = last;
+	else
+		hdr->tail = last;
+	hdr->count += other->count;
+
+	other->head = NULL;
+	other->tail = NULL;
+	other->count = 0;
+}
+
+
+// ---------------- getStats/resetStats/setTrace ------------------
+// Parameters: getStats():  where to store the counts
+//             resetStats(): None
+//             setTrace():  trace hook (NULL to turn tracing off)
+//
+// Instrumentation, for DblList_Int, DblPool_Int and DblListHdr_Int; see
+// listStats.h.  getStats() takes a snapshot of the counts for the calling
+// thread, and resetStats() sets them back to zero.  setTrace() installs a
+// hook which is called at the end of getHead(), getTail(), addTail(), the
+// addTailN()s, the bulk queries, and the header's recount() and free(),
+// with the counts for that call.  ('compares' counts the values looked at
+// by the bulk queries; 'strcmps' and 'bytesDup' are always 0.)
+//
+// Unless the program was built with -DLIST_STATS, getStats() always reports
+// zeros, and the hook is never called.
+//
+// ERRORS:
+//   - getStats(): Pointer is NULL.  Print error.
+
+void dblList_Int__getStats(ListStats *stats)
+{
+	if (!stats) {
+		fprintf(stderr, "dblList_Int__getStats: The pointer is NULL.\n");
+		return;
+	}
+
+#ifdef LIST_STATS
+	*stats = dblList_Int__stats;
+#else
+	memset(stats, 0, sizeof(ListStats));
+#endif
+}
+void dblList_Int__resetStats()
+{
+#ifdef LIST_STATS
+	memset(&dblList_Int__stats, 0, sizeof(ListStats));
+#endif
+}
+void dblList_Int__setTrace(ListStats_Trace hook)
+{
+#ifdef LIST_STATS
+	dblList_Int__trace = hook;
+#else
+	(void)hook;
+#endif
+}
@@ -0,0 +1,61 @@
+/*
+ * dblListIntExt.h
+ * Author:Qiwei Li
+ *
+ * Everything that DblList_Int offers beyond the methods declared in
+ * dblListInt.h.  Each method is documented where it is defined, in
+ * dblListInt.c.
+ */
+
+#ifndef __DBLLISTINTEXT_H__
+#define __DBLLISTINTEXT_H__
+
+#include "dblListInt.h"
+#include "listStats.h"
+
+typedef struct DblList_Int_Pool DblPool_Int;
+typedef struct DblList_Int_Header DblListHdr_Int;
+
+
+/* Pools */
+DblPool_Int *dblPool_Int__alloc();
+void dblPool_Int__free(DblPool_Int *pool);
+DblList_Int *dblPool_Int__allocNode(DblPool_Int *pool, int val);
+void dblPool_Int__freeNode(DblPool_Int *pool, DblList_Int *node);
+
+/* Bulk inserts */
+void dblList_Int__addTailN(DblList_Int *list, const int *vals, int n);
+void dblPool_Int__addTailN(DblPool_Int *pool, DblList_Int *list, const int *vals, int n);
+
+/* Queries over the whole list that 'node' is on */
+int dblList_Int__getMin(DblList_Int *node);
+int dblList_Int__getMax(DblList_Int *node);
+long long dblList_Int__sum(DblList_Int *node);
+int dblList_Int__countRange(DblList_Int *node, int lo, int hi);
+DblList_Int *dblList_Int__findVal(DblList_Int *node, int val);
+
+/* DblListHdr_Int: a list which knows its head, tail and count */
+DblListHdr_Int *dblListHdr_Int__alloc();
+DblListHdr_Int *dblListHdr_Int__allocPool(DblPool_Int *pool);
+void dblListHdr_Int__free(DblListHdr_Int *hdr);
+
+DblList_Int *dblListHdr_Int__getHead(DblListHdr_Int *hdr);
+DblList_Int *dblListHdr_Int__getTail(DblListHdr_Int *hdr);
+int dblListHdr_Int__count(DblListHdr_Int *hdr);
+int dblListHdr_Int__recount(DblListHdr_Int *hdr);
+
+void dblListHdr_Int__pushHead(DblListHdr_Int *hdr, int value);
+void dblListHdr_Int__pushTail(DblListHdr_Int *hdr, int value);
+void dblListHdr_Int__pushTailN(DblListHdr_Int *hdr, const int *vals, int n);
+int dblListHdr_Int__popHead(DblListHdr_Int *hdr);
+int dblListHdr_Int__popTail(DblListHdr_Int *hdr);
+void dblListHdr_Int__addAfter(DblListHdr_Int *hdr, DblList_Int *pos, DblList_Int *node);
+void dblListHdr_Int__remove(DblListHdr_Int *hdr, DblList_Int *node);
+void dblListHdr_Int__splice(DblListHdr_Int *hdr, DblList_Int *pos, DblListHdr_Int *other);
+
+/* Instrumentation (see listStats.h) */
+void dblList_Int__getStats(ListStats *stats);
+void dblList_Int__resetStats();
+void dblList_Int__setTrace(ListStats_Trace hook);
+
+#endif
@@ -0,0 +1,990 @@
+/*
+ * encUnrolledListStr.c
+ * Author:Qiwei Li
+ *
+ * Unrolled lists of strings; see encUnrolledListStr.h.
+ *
+ * An EncList_Str node is 64 bytes (plus malloc() overhead), for every
+ * string; a scan over the list visits one cache line per string, and has to
+ * wait for each 'next' pointer before it can fetch the following node.
+ * Here, each block holds up to ENCULIST_STR_SLOTS strings, and keeps the
+ * key prefixes, string pointers, lengths and inline copies of its slots in
+ * separate arrays - so a full block costs about 38 bytes per string
+ * (including the copy, for a dup'ed string shorter than ENCULIST_STR_INLINE
+ * bytes), and a scan such as getMin() reads the keys of 16 strings from two
+ * cache lines.
+ *
+ * As in EncList_Str, each slot caches the first 8 bytes of its string as a
+ * big-endian integer ('key'), so that most comparisons never touch the
+ * string itself.
+ *
+ * Blocks are filled by addTail() and addHead() (and by merge() and sort());
+ * insertAt() splits a full block in two, and removeAt() merges a block that
+ * is less than a quarter full into its neighbor, if they fit in one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "encUnrolledListStr.h"
+
+#define ENCULIST_STR_PREFIX	8
+#define ENCULIST_STR_INLINE	16
+
+struct EncUnrolledList_Str_Block {
+	EncUList_Str_Block	*next;
+	EncUList_Str_Block	*prev;
+	int			n;		/* slots in use: [0, n) */
+	unsigned int		owned;		/* bit i: str[i] was malloc()ed */
+	unsigned int		inlined;	/* bit i: str[i] is inl[i] */
+	uint64_t		key[ENCULIST_STR_SLOTS];
+	char			*str[ENCULIST_STR_SLOTS];
+	unsigned int		len[ENCULIST_STR_SLOTS];
+	char			inl[ENCULIST_STR_SLOTS][ENCULIST_STR_INLINE];
+};
+
+struct EncUnrolledList_Str {
+	EncUList_Str_Block	*head;
+	EncUList_Str_Block	*tail;
+	int			count;
+};
+
+
+/* The first 8 bytes of the string, as a big-endian integer (short strings
+ * are padded with zeros), so that keys compare just like the strings do
+ */
+static uint64_t encUList_Str__prefix(const char *str, size_t len)
+{
+	unsigned char buf[ENCULIST_STR_PREFIX] = { 0 };
+	uint64_t key = 0;
+	int i;
+
+	memcpy(buf, str, len < ENCULIST_STR_PREFIX ? len : ENCULIST_STR_PREFIX);
+	for (i = 0; i < ENCULIST_STR_PREFIX; i++)
+		key = (key << 8) | buf[i];
+
+	return key;
+}
+
+/* Compares slot 'i' of block 'a' with slot 'j' of block 'b', like strcmp() */
+static inline int encUList_Str__cmp(EncUList_Str_Block *a, int i, EncUList_Str_Block *b, int j)
+{
+	unsigned int len;
+	int cmp;
+
+	if (a->key[i] != b->key[j])
+		return a->key[i] < b->key[j] ? -1 : 1;
+
+	len = a->len[i] < b->len[j] ? a->len[i] : b->len[j];
+	if (len > ENCULIST_STR_PREFIX) {
+		cmp = memcmp(a->str[i] + ENCULIST_STR_PREFIX, b->str[j] + ENCULIST_STR_PREFIX,
+		             len - ENCULIST_STR_PREFIX);
+		if (cmp)
+			return cmp;
+	}
+	return (a->len[i] > b->len[j]) - (a->len[i] < b->len[j]);
+}
+
+static EncUList_Str_Block *encUList_Str__newBlock()
+{
+	EncUList_Str_Block *block;
+
+	block = (EncUList_Str_Block *)malloc(sizeof(EncUList_Str_Block));
+	if (!block) {
+		perror("malloc");
+		return NULL;
+	}
+
+	block->next = NULL;
+	block->prev = NULL;
+	block->n = 0;
+	block->owned = 0;
+	block->inlined = 0;
+
+	return block;
+}
+
+/* Frees the strings that the block owns, and then the block */
+static void encUList_Str__freeBlock(EncUList_Str_Block *block)
+{
+	int i;
+
+	for (i = 0; i < block->n; i++) {
+		if (block->owned & (1u << i))
+			free(block->str[i]);
+	}
+	free(block);
+}
+
+/* Moves 'n' slots from src[si..] to dst[di..]; the ranges may overlap.
+ * Inline strings move with their slots (and their pointers are fixed up).
+ */
+static void encUList_Str__move(EncUList_Str_Block *dst, int di, EncUList_Str_Block *src, int si, int n)
+{
+	unsigned int mask, owned, inlined;
+	int i;
+
+	if (n <= 0)
+		return;
+
+	mask = (1u << n) - 1;
+	owned = (src->owned >> si) & mask;
+	inlined = (src->inlined >> si) & mask;
+
+	memmove(&dst->key[di], &src->key[si], sizeof(uint64_t) * n);
+	memmove(&dst->str[di], &src->str[si], sizeof(char *) * n);
+	memmove(&dst->len[di], &src->len[si], sizeof(unsigned int) * n);
+	dst->owned = (dst->owned & ~(mask << di)) | (owned << di);
+	dst->inlined = (dst->inlined & ~(mask << di)) | (inlined << di);
+
+	if (inlined) {
+		memmove(dst->inl[di], src->inl[si], ENCULIST_STR_INLINE * n);
+		for (i = 0; i < n; i++) {
+			if (inlined & (1u << i))
+				dst->str[di + i] = dst->inl[di + i];
+		}
+	}
+}
+
+/* Links 'block' into the chain right after 'pos' (or at the front, if pos
+ * is NULL)
+ */
+static void encUList_Str__linkAfter(EncUList_Str *obj, EncUList_Str_Block *pos, EncUList_Str_Block *block)
+{
+	block->prev = pos;
+	block->next = pos ? pos->next : obj->head;
+	if (block->next)
+		block->next->prev = block;
+	else
+		obj->tail = block;
+	if (pos)
+		pos->next = block;
+	else
+		obj->head = block;
+}
+
+static void encUList_Str__unlink(EncUList_Str *obj, EncUList_Str_Block *block)
+{
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		obj->head = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+	else
+		obj->tail = block->prev;
+	block->prev = NULL;
+	block->next = NULL;
+}
+
+/* Finds the block which holds position 'index' (0 <= index < count), walking
+ * from whichever end is closer.  The slot within the block goes in *slot.
+ */
+static EncUList_Str_Block *encUList_Str__find(EncUList_Str *obj, int index, int *slot)
+{
+	EncUList_Str_Block *block;
+	int pos;
+
+	if (index <= obj->count / 2) {
+		for (block = obj->head; index >= block->n; block = block->next)
+			index -= block->n;
+		*slot = index;
+	} else {
+		pos = obj->count;
+		for (block = obj->tail; ; block = block->prev) {
+			pos -= block->n;
+			if (index >= pos)
+				break;
+		}
+		*slot = index - pos;
+	}
+
+	return block;
+}
+
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None
+//
+// Allocates a new EncUList_Str object, and initializes it to hold an empty
+// list (no blocks are allocated until the first string is added).
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+EncUList_Str *encUList_Str__alloc()
+{
+	EncUList_Str *obj;
+
+	obj = (EncUList_Str *)malloc(sizeof(EncUList_Str));
+	if (!obj) {
+		perror("malloc");
+		return NULL;
+	}
+
+	obj->head = NULL;
+	obj->tail = NULL;
+	obj->count = 0;
+
+	return obj;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Frees the object, every block, and every string which was dup'ed.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void encUList_Str__free(EncUList_Str *obj)
+{
+	EncUList_Str_Block *block, *next;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__free: The object is NULL.\n");
+		return;
+	}
+
+	for (block = obj->head; block; block = next) {
+		next = block->next;
+		encUList_Str__freeBlock(block);
+	}
+	free(obj);
+}
+
+
+// ---------------- insertAt --------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             index (0 through count(), inclusive)
+//             string
+//             dup (if set, the list keeps its own copy of the string)
+//
+// Inserts the string so that it ends up at position 'index'.  Shifts at most
+// ENCULIST_STR_SLOTS-1 slots within one block; if the block is full, it is
+// split in two first (except at the ends of the list, where a new block is
+// started instead, so that addHead()/addTail() fill blocks completely).
+//
+// addHead(), addTail(): Equivalent to insertAt() at 0 or count().
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+//   - The string is NULL, or the index is invalid.  Print error.
+//   - malloc() fails.  Print error; the list is not changed.
+
+void encUList_Str__insertAt(EncUList_Str *obj, int index, char *string, int dup)
+{
+	EncUList_Str_Block *block, *newBlock;
+	size_t len;
+	char *str;
+	int slot;
+
+	if (!obj || !string) {
+		fprintf(stderr, "encUList_Str__insertAt: The object or string is NULL.\n");
+		return;
+	}
+	if (index < 0 || index > obj->count) {
+		fprintf(stderr, "encUList_Str__insertAt: The index is invalid.\n");
+		return;
+	}
+
+	/* Copy a long string before changing anything */
+	len = strlen(string);
+	str = string;
+	if (dup && len >= ENCULIST_STR_INLINE) {
+		str = (char *)malloc(len + 1);
+		if (!str) {
+			perror("malloc");
+			return;
+		}
+		memcpy(str, string, len + 1);
+	}
+
+	/* Find the block and slot; at a boundary, prefer the earlier block */
+	if (!obj->head) {
+		block = NULL;
+		slot = 0;
+	} else if (index == obj->count) {
+		block = obj->tail;
+		slot = block->n;
+	} else {
+		block = encUList_Str__find(obj, index, &slot);
+		if (slot == 0 && block->prev && block->prev->n < ENCULIST_STR_SLOTS) {
+			block = block->prev;
+			slot = block->n;
+		}
+	}
+
+	/* Make room */
+	if (!block || block->n == ENCULIST_STR_SLOTS) {
+		newBlock = encUList_Str__newBlock();
+		if (!newBlock) {
+			if (str != string)
+				free(str);
+			return;
+		}
+
+		if (!block) {
+			encUList_Str__linkAfter(obj, NULL, newBlock);
+		} else if (slot == ENCULIST_STR_SLOTS) {
+			encUList_Str__linkAfter(obj, block, newBlock);
+			slot = 0;
+		} else if (slot == 0 && !block->prev) {
+			encUList_Str__linkAfter(obj, NULL, newBlock);
+		} else {
+			/* Split: the upper half moves to the new block */
+			encUList_Str__move(newBlock, 0, block, ENCULIST_STR_SLOTS / 2, ENCULIST_STR_SLOTS / 2);
+			newBlock->n = ENCULIST_STR_SLOTS / 2;
+			block->n = ENCULIST_STR_SLOTS / 2;
+			encUList_Str__linkAfter(obj, block, newBlock);
+			if (slot >= ENCULIST_STR_SLOTS / 2) {
+				slot -= ENCULIST_STR_SLOTS / 2;
+				block = newBlock;
+			}
+			newBlock = NULL;
+		}
+		if (newBlock)
+			block = newBlock;
+	}
+
+	encUList_Str__move(block, slot + 1, block, slot, block->n - slot);
+	block->owned &= ~(1u << slot);
+	block->inlined &= ~(1u << slot);
+	if (dup && str == string) {
+		memcpy(block->inl[slot], string, len + 1);
+		str = block->inl[slot];
+		block->inlined |= 1u << slot;
+	} else if (dup)
+		block->owned |= 1u << slot;
+	block->key[slot] = encUList_Str__prefix(str, len);
+	block->str[slot] = str;
+	block->len[slot] = len;
+	block->n++;
+	obj->count++;
+}
+
+void encUList_Str__addHead(EncUList_Str *obj, char *string, int dup)
+{
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__addHead: The object is NULL.\n");
+		return;
+	}
+	encUList_Str__insertAt(obj, 0, string, dup);
+}
+
+void encUList_Str__addTail(EncUList_Str *obj, char *string, int dup)
+{
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__addTail: The object is NULL.\n");
+		return;
+	}
+	encUList_Str__insertAt(obj, obj->count, string, dup);
+}
+
+// ---------------- removeAt --------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             index (0 through count()-1, inclusive)
+//
+// Removes the string at position 'index' (freeing it, if it was dup'ed).
+// An empty block is freed; a block which drops below a quarter full is
+// merged with a neighbor, if the two fit in one block.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+//   - The index is invalid.  Print error.
+
+void encUList_Str__removeAt(EncUList_Str *obj, int index)
+{
+	EncUList_Str_Block *block, *other;
+	int slot;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__removeAt: The object is NULL.\n");
+		return;
+	}
+	if (index < 0 || index >= obj->count) {
+		fprintf(stderr, "encUList_Str__removeAt: The index is invalid.\n");
+		return;
+	}
+
+	block = encUList_Str__find(obj, index, &slot);
+	if (block->owned & (1u << slot))
+		free(block->str[slot]);
+	encUList_Str__move(block, slot, block, slot + 1, block->n - slot - 1);
+	block->n--;
+	obj->count--;
+
+	if (!block->n) {
+		encUList_Str__unlink(obj, block);
+		free(block);
+		return;
+	}
+
+	if (block->n < ENCULIST_STR_SLOTS / 4) {
+		/* Merge the later of the two blocks into the earlier one */
+		other = block->next;
+		if (!other || block->n + other->n > ENCULIST_STR_SLOTS) {
+			other = block;
+			block = block->prev;
+		}
+		if (block && block->n + other->n <= ENCULIST_STR_SLOTS) {
+			encUList_Str__move(block, block->n, other, 0, other->n);
+			block->n += other->n;
+			encUList_Str__unlink(obj, other);
+			free(other);
+		}
+	}
+}
+
+
+// ---------------- count -----------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Returns the number of strings in the list, in O(1).
+//
+// ERRORS:
+//   'this' is NULL.  Print error and return -1.
+
+int encUList_Str__count(EncUList_Str *obj)
+{
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__count: The object is NULL.\n");
+		return -1;
+	}
+
+	return obj->count;
+}
+
+// ---------------- getMin/getMax ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Searches the list for the minimum or maximum string, with a brute-force
+// scan.  The scan only reads the keys of each block, until it finds a key
+// which ties with the best one so far.
+//
+// Returns NULL if the list is empty.
+//
+// ERRORS:
+//   'this' is NULL.  Print error and return NULL.
+
+char *encUList_Str__getMin(EncUList_Str *obj)
+{
+	EncUList_Str_Block *block, *min;
+	uint64_t key;
+	int i, slot;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__getMin: The object is NULL.\n");
+		return NULL;
+	}
+
+	if (!obj->head)
+		return NULL;
+
+	min = obj->head;
+	slot = 0;
+	key = min->key[0];
+	for (block = obj->head; block; block = block->next) {
+		/* Fetch the next block's keys while this block is scanned */
+		if (block->next) {
+			__builtin_prefetch(&block->next->key[0]);
+			__builtin_prefetch(&block->next->key[ENCULIST_STR_SLOTS - 1]);
+		}
+		for (i = 0; i < block->n; i++) {
+			if (block->key[i] > key)
+				continue;
+			if (block->key[i] < key || encUList_Str__cmp(block, i, min, slot) < 0) {
+				min = block;
+				slot = i;
+				key = block->key[i];
+			}
+		}
+	}
+
+	return min->str[slot];
+}
+
+char *encUList_Str__getMax(EncUList_Str *obj)
+{
+	EncUList_Str_Block *block, *max;
+	uint64_t key;
+	int i, slot;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__getMax: The object is NULL.\n");
+		return NULL;
+	}
+
+	if (!obj->head)
+		return NULL;
+
+	max = obj->head;
+	slot = 0;
+	key = max->key[0];
+	for (block = obj->head; block; block = block->next) {
+		/* Fetch the next block's keys while this block is scanned */
+		if (block->next) {
+			__builtin_prefetch(&block->next->key[0]);
+			__builtin_prefetch(&block->next->key[ENCULIST_STR_SLOTS - 1]);
+		}
+		for (i = 0; i < block->n; i++) {
+			if (block->key[i] < key)
+				continue;
+			if (block->key[i] > key || encUList_Str__cmp(block, i, max, slot) > 0) {
+				max = block;
+				slot = i;
+				key = block->key[i];
+			}
+		}
+	}
+
+	return max->str[slot];
+}
+
+// ---------------- getHead/getTail/index ----------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             index (index() only)
+//
+// Return the first, last, or index-th string of the list.  getHead() and
+// getTail() return NULL if the list is empty.  index() walks the blocks
+// from whichever end is closer, so it takes O(count/ENCULIST_STR_SLOTS).
+//
+// ERRORS:
+//   - 'this' is NULL.  Print error and return NULL.
+//   - The index is invalid.  Print error and return NULL.
+
+char *encUList_Str__getHead(EncUList_Str *obj)
+{
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__getHead: The object is NULL.\n");
+		return NULL;
+	}
+
+	return obj->head ? obj->head->str[0] : NULL;
+}
+
+char *encUList_Str__getTail(EncUList_Str *obj)
+{
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__getTail: The object is NULL.\n");
+		return NULL;
+	}
+
+	return obj->tail ? obj->tail->str[obj->tail->n - 1] : NULL;
+}
+
+char *encUList_Str__index(EncUList_Str *obj, int index)
+{
+	EncUList_Str_Block *block;
+	int slot;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__index: The object is NULL.\n");
+		return NULL;
+	}
+	if (index < 0 || index >= obj->count) {
+		fprintf(stderr, "encUList_Str__index: The index is invalid.\n");
+		return NULL;
+	}
+
+	block = encUList_Str__find(obj, index, &slot);
+	return block->str[slot];
+}
+
+
+// ---------------- merge -----------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             another object
+//
+// Just like encList_Str__merge(): both lists must be sorted; all of the
+// strings of rhs are merged into lhs (ties go to lhs first), and rhs is
+// left empty.  The result is packed into full blocks.
+//
+// The output is written into the blocks that the input has already been
+// read out of; two spare blocks are allocated up front, and that is always
+// enough, so the merge can't fail half way through.
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error.
+//   - malloc() fails.  Print error; neither list is changed.
+
+void encUList_Str__merge(EncUList_Str *lhs, EncUList_Str *rhs)
+{
+	EncUList_Str_Block *a, *b, *spare = NULL, *out = NULL, *head = NULL, *block;
+	int i = 0, j = 0, k;
+
+	if (!lhs || !rhs) {
+		fprintf(stderr, "encUList_Str__merge: The object(s) is NULL.\n");
+		return;
+	}
+
+	if (!rhs->head)
+		return;
+	if (!lhs->head) {
+		encUList_Str__append(lhs, rhs);
+		return;
+	}
+
+	for (k = 0; k < 2; k++) {
+		block = encUList_Str__newBlock();
+		if (!block) {
+			while (spare) {
+				block = spare->next;
+				free(spare);
+				spare = block;
+			}
+			return;
+		}
+		block->next = spare;
+		spare = block;
+	}
+
+	a = lhs->head;
+	b = rhs->head;
+	while (a || b) {
+		EncUList_Str_Block *src;
+		int si;
+
+		/* Take the smaller string; ties come from lhs */
+		if (!b || (a && encUList_Str__cmp(a, i, b, j) <= 0)) {
+			src = a;
+			si = i++;
+		} else {
+			src = b;
+			si = j++;
+		}
+
+		/* Start a new output block, if needed */
+		if (!out || out->n == ENCULIST_STR_SLOTS) {
+			block = spare;
+			spare = spare->next;
+			block->n = 0;
+			block->owned = 0;
+			block->inlined = 0;
+			block->next = NULL;
+			block->prev = out;
+			if (out)
+				out->next = block;
+			else
+				head = block;
+			out = block;
+		}
+		encUList_Str__move(out, out->n, src, si, 1);
+		out->n++;
+
+		/* An input block that has been read out becomes a spare */
+		if (a && i == a->n) {
+			block = a;
+			a = a->next;
+			i = 0;
+			block->next = spare;
+			spare = block;
+		}
+		if (b && j == b->n) {
+			block = b;
+			b = b->next;
+			j = 0;
+			block->next = spare;
+			spare = block;
+		}
+	}
+
+	while (spare) {
+		block = spare->next;
+		free(spare);
+		spare = block;
+	}
+
+	lhs->head = head;
+	lhs->tail = out;
+	lhs->count += rhs->count;
+	rhs->head = NULL;
+	rhs->tail = NULL;
+	rhs->count = 0;
+}
+
+// ---------------- append ----------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             another object
+//
+// Moves all of the strings of rhs to the end of lhs, in O(1), and leaves
+// rhs empty.  If the last block of lhs and the first block of rhs fit in one
+// block, they are combined.
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error.
+
+void encUList_Str__append(EncUList_Str *lhs, EncUList_Str *rhs)
+{
+	EncUList_Str_Block *tail, *head;
+
+	if (!lhs || !rhs) {
+		fprintf(stderr, "encUList_Str__append: The object(s) is NULL.\n");
+		return;
+	}
+
+	tail = lhs->tail;
+	head = rhs->head;
+	if (!head)
+		return;
+
+	if (!tail) {
+		lhs->head = head;
+	} else if (tail->n + head->n <= ENCULIST_STR_SLOTS) {
+		encUList_Str__move(tail, tail->n, head, 0, head->n);
+		tail->n += head->n;
+		encUList_Str__unlink(rhs, head);
+		free(head);
+		if (rhs->head) {
+			tail->next = rhs->head;
+			rhs->head->prev = tail;
+		}
+	} else {
+		tail->next = head;
+		head->prev = tail;
+	}
+	if (rhs->tail)
+		lhs->tail = rhs->tail;
+	lhs->count += rhs->count;
+
+	rhs->head = NULL;
+	rhs->tail = NULL;
+	rhs->count = 0;
+}
+
+// ---------------- splitAt ---------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             index (0 through count(), inclusive)
+//
+// Just like encList_Str__splitAt(): the strings from position 'index' on
+// are moved to a new list, which is returned.  At most one block is split.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return NULL.
+//   - The index is invalid.  Print error and return NULL.
+//   - malloc() fails.  Print error and return NULL; the list is not changed.
+
+EncUList_Str *encUList_Str__splitAt(EncUList_Str *obj, int index)
+{
+	EncUList_Str *newObj;
+	EncUList_Str_Block *block, *newBlock;
+	int slot;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__splitAt: The object is NULL.\n");
+		return NULL;
+	}
+	if (index < 0 || index > obj->count) {
+		fprintf(stderr, "encUList_Str__splitAt: The index is invalid.\n");
+		return NULL;
+	}
+
+	newObj = encUList_Str__alloc();
+	/* Errors should be handled in encUList_Str__alloc */
+	if (!newObj)
+		return NULL;
+
+	/* Move nothing into the new list */
+	if (index == obj->count)
+		return newObj;
+
+	block = encUList_Str__find(obj, index, &slot);
+	if (slot) {
+		/* Split the block; the upper part becomes a block of its own */
+		newBlock = encUList_Str__newBlock();
+		if (!newBlock) {
+			free(newObj);
+			return NULL;
+		}
+		encUList_Str__move(newBlock, 0, block, slot, block->n - slot);
+		newBlock->n = block->n - slot;
+		block->n = slot;
+		encUList_Str__linkAfter(obj, block, newBlock);
+		block = newBlock;
+	}
+
+	/* Cut the chain just before 'block' */
+	newObj->head = block;
+	newObj->tail = obj->tail;
+	newObj->count = obj->count - index;
+
+	obj->tail = block->prev;
+	if (block->prev)
+		block->prev->next = NULL;
+	else
+		obj->head = NULL;
+	block->prev = NULL;
+	obj->count = index;
+
+	return newObj;
+}
+
+// ---------------- sort ------------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Sorts the list (stably), and packs it into full blocks.  The slots (and
+// inline strings) are copied out to a temporary array, merge sorted there,
+// and copied back.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+//   - malloc() fails.  Print error; the list is not changed.
+
+typedef struct EncUList_Str_Entry EncUList_Str_Entry;
+struct EncUList_Str_Entry {
+	uint64_t	key;
+	char		*str;		/* NULL if the string is in 'inl' */
+	unsigned int	len;
+	int		owned;
+	char		inl[ENCULIST_STR_INLINE];
+};
+
+static inline int encUList_Str__cmpEntry(EncUList_Str_Entry *a, EncUList_Str_Entry *b)
+{
+	unsigned int len;
+	int cmp;
+
+	if (a->key != b->key)
+		return a->key < b->key ? -1 : 1;
+
+	len = a->len < b->len ? a->len : b->len;
+	if (len > ENCULIST_STR_PREFIX) {
+		cmp = memcmp((a->str ? a->str : a->inl) + ENCULIST_STR_PREFIX,
+		             (b->str ? b->str : b->inl) + ENCULIST_STR_PREFIX,
+		             len - ENCULIST_STR_PREFIX);
+		if (cmp)
+			return cmp;
+	}
+	return (a->len > b->len) - (a->len < b->len);
+}
+
+void encUList_Str__sort(EncUList_Str *obj)
+{
+	EncUList_Str_Entry *entries, *tmp, *src, *dst, *swap;
+	EncUList_Str_Block *block, *next;
+	int n, i, k, width;
+
+	if (!obj) {
+		fprintf(stderr, "encUList_Str__sort: The object is NULL.\n");
+		return;
+	}
+
+	n = obj->count;
+	if (n < 2)
+		return;
+
+	entries = (EncUList_Str_Entry *)malloc(sizeof(EncUList_Str_Entry) * 2 * (size_t)n);
+	if (!entries) {
+		perror("malloc");
+		return;
+	}
+	tmp = entries + n;
+
+	/* Copy out */
+	k = 0;
+	for (block = obj->head; block; block = block->next) {
+		for (i = 0; i < block->n; i++, k++) {
+			entries[k].key = block->key[i];
+			entries[k].str = block->str[i];
+			entries[k].len = block->len[i];
+			entries[k].owned = (block->owned >> i) & 1;
+			if (block->inlined & (1u << i)) {
+				memcpy(entries[k].inl, block->inl[i], block->len[i] + 1);
+				entries[k].str = NULL;
+			}
+		}
+	}
+
+	/* Bottom-up merge sort, ping-ponging between the two halves */
+	src = entries;
+	dst = tmp;
+	for (width = 1; width < n; width *= 2) {
+		int lo;
+
+		for (lo = 0; lo < n; lo += 2 * width) {
+			int mid = lo + width < n ? lo + width : n;
+			int hi = lo + 2 * width < n ? lo + 2 * width : n;
+			int a = lo, b = mid;
+
+			for (k = lo; k < hi; k++) {
+				if (a < mid && (b >= hi || encUList_Str__cmpEntry(&src[a], &src[b]) <= 0))
+					dst[k] = src[a++];
+				else
+					dst[k] = src[b++];
+			}
+		}
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	/* Copy back, filling each block; free the blocks that are left over */
+	k = 0;
+	for (block = obj->head; block; block = next) {
+		next = block->next;
+		if (k == n) {
+			encUList_Str__unlink(obj, block);
+			free(block);
+			continue;
+		}
+
+		block->owned = 0;
+		block->inlined = 0;
+		for (i = 0; i < ENCULIST_STR_SLOTS && k < n; i++, k++) {
+			block->key[i] = src[k].key;
+			block->str[i] = src[k].str;
+			block->len[i] = src[k].len;
+			block->owned |= (unsigned int)src[k].owned << i;
+			if (!src[k].str) {
+				memcpy(block->inl[i], src[k].inl, src[k].len + 1);
+				block->str[i] = block->inl[i];
+				block->inlined |= 1u << i;
+			}
+		}
+		block->n = i;
+	}
+
+	free(entries);
+}
+
+
+// ---------------- iter/iterNext ----------------------------
+// Parameters: 'this' pointer (of the wrapper class), and an iterator
+//             (iterNext(): just the iterator)
+//
+// iter() starts the iterator at the head of the list; each call to
+// iterNext() returns the next string, or NULL after the last one.  The list
+// must not be changed while it is being iterated.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error (iterNext() returns NULL).
+
+void encUList_Str__iter(EncUList_Str *obj, EncUList_Str_Iter *it)
+{
+	if (!obj || !it) {
+		fprintf(stderr, "encUList_Str__iter: The object or iterator is NULL.\n");
+		return;
+	}
+
+	it->block = obj->head;
+	it->slot = 0;
+}
+
+char *encUList_Str__iterNext(EncUList_Str_Iter *it)
+{
+	if (!it) {
+		fprintf(stderr, "encUList_Str__iterNext: The iterator is NULL.\n");
+		return NULL;
+	}
+
+	while (it->block && it->slot >= it->block->n) {
+		it->block = it->block->next;
+		it->slot = 0;
+	}
+	if (!it->block)
+		return NULL;
+
+	return it->block->str[it->slot++];
+}
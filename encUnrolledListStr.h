@@ -0,0 +1,52 @@
+/*
+ * encUnrolledListStr.h
+ * Author:Qiwei Li
+ *
+ * EncUList_Str: an "unrolled" version of EncList_Str.
+ *
+ * Rather than one node per string, the list is a chain of blocks, each of
+ * which holds up to ENCULIST_STR_SLOTS strings.  The list methods are the
+ * same as for EncList_Str, and behave the same way - the difference is
+ * that there are no per-string node objects, so strings are named by their
+ * index (or visited with an iterator) instead of by node pointers.
+ */
+
+#ifndef __ENCUNROLLEDLISTSTR_H__
+#define __ENCUNROLLEDLISTSTR_H__
+
+#define ENCULIST_STR_SLOTS	16
+
+typedef struct EncUnrolledList_Str EncUList_Str;
+typedef struct EncUnrolledList_Str_Block EncUList_Str_Block;
+
+/* Iterator; see encUList_Str__iter() */
+typedef struct EncUList_Str_Iter EncUList_Str_Iter;
+struct EncUList_Str_Iter {
+	EncUList_Str_Block	*block;
+	int			slot;
+};
+
+EncUList_Str *encUList_Str__alloc();
+void encUList_Str__free(EncUList_Str *obj);
+
+void encUList_Str__addHead(EncUList_Str *obj, char *string, int dup);
+void encUList_Str__addTail(EncUList_Str *obj, char *string, int dup);
+void encUList_Str__insertAt(EncUList_Str *obj, int index, char *string, int dup);
+void encUList_Str__removeAt(EncUList_Str *obj, int index);
+
+int encUList_Str__count(EncUList_Str *obj);
+char *encUList_Str__getMin(EncUList_Str *obj);
+char *encUList_Str__getMax(EncUList_Str *obj);
+char *encUList_Str__getHead(EncUList_Str *obj);
+char *encUList_Str__getTail(EncUList_Str *obj);
+char *encUList_Str__index(EncUList_Str *obj, int index);
+
+void encUList_Str__merge(EncUList_Str *lhs, EncUList_Str *rhs);
+void encUList_Str__append(EncUList_Str *lhs, EncUList_Str *rhs);
+EncUList_Str *encUList_Str__splitAt(EncUList_Str *obj, int index);
+void encUList_Str__sort(EncUList_Str *obj);
+
+void encUList_Str__iter(EncUList_Str *obj, EncUList_Str_Iter *it);
+char *encUList_Str__iterNext(EncUList_Str_Iter *it);
+
+#endif
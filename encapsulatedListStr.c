@@ -5,409 +5,3631 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
 #include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+#define ENCLIST_STR_INTERNAL	/* the node layout lives here */
+#include "encapsulatedListStrCursor.h"
+#include "listStats.h"
+
+/* Instrumentation (see listStats.h); all of this compiles away without
+ * -DLIST_STATS
+ */
+#ifdef LIST_STATS
+static __thread ListStats encList_Str__stats;
+static __thread int encList_Str__depth;
+static ListStats_Trace encList_Str__trace;
+#endif
+
+#define ENCLIST_STR_STAT(field, n)	LIST_STATS_ADD(encList_Str__stats, field, n)
+#define ENCLIST_STR_BEGIN()		LIST_STATS_BEGIN(encList_Str__stats, encList_Str__depth, statsMark)
+#define ENCLIST_STR_END(op) \
+	LIST_STATS_END(encList_Str__stats, encList_Str__depth, statsMark, encList_Str__trace, op)
+
+typedef struct EncList_Str_Index EncList_Str_Index;
 
 struct EncapsulatedList_Str {
-	EncNode_Str	*head;
+	EncNode_Str		*head;
+	EncNode_Str		*tail;
+	int			count;
+	EncPool_Str		*pool;		/* NULL if nodes come from malloc() */
+	EncList_Str_Index	*index;		/* NULL unless setIndex() was used */
+	EncIntern_Str		*intern;	/* NULL unless setIntern() was used */
+};
+
+/* The node itself (struct EncapsulatedList_Str_Node) is defined in
+ * encapsulatedListStrCursor.h, so that the inline cursor methods can see it.
+ */
+
+/* Values for EncNode_Str.flags */
+#define ENCNODE_STR_OWNED	0x1	/* 'str' was malloc()ed for this node */
+#define ENCNODE_STR_POOLED	0x2	/* the node lives in a pool slab */
+#define ENCNODE_STR_BATCH	0x4	/* the node lives in a batch (addTailN) */
+#define ENCNODE_STR_INTERNED	0x8	/* 'str' is shared, from an EncIntern_Str */
+#define ENCNODE_STR_BATCH_SHIFT	8	/* ...and the rest of 'flags' is its index */
+
+/* A batch of nodes, allocated all at once by addTailN(), followed by the
+ * copies of their strings.  Each node keeps its index in the batch, so that
+ * freeing a node can find the batch; the batch is freed with its last node.
+ */
+#define ENCLIST_STR_BATCH_MAX	(1 << 22)
+
+typedef struct EncList_Str_Batch EncList_Str_Batch;
+struct EncList_Str_Batch {
+	int		live;
+	EncNode_Str	nodes[] __attribute__((aligned(64)));
+};
+
+/* Pools (see encPool_Str__alloc() below).  Slabs are aligned to their own
+ * size, so that the pool which owns a node can be found from the address of
+ * the node alone.  A slot can hold either a node or a list wrapper, and is
+ * aligned so that a node never straddles two cache lines.
+ */
+#define ENCPOOL_STR_SLAB_SIZE	(64 * 1024)
+#define ENCPOOL_STR_CHUNK_SIZE	(64 * 1024)
+
+typedef union EncPool_Str_Slot EncPool_Str_Slot;
+union EncPool_Str_Slot {
+	EncNode_Str		node;
+	EncList_Str		list;
+	EncPool_Str_Slot	*nextFree;
+} __attribute__((aligned(64)));
+
+typedef struct EncPool_Str_Slab EncPool_Str_Slab;
+struct EncPool_Str_Slab {
+	EncPool_Str		*pool;
+	EncPool_Str_Slab	*next;
+	EncPool_Str_Slot	slots[];
+};
+
+#define ENCPOOL_STR_SLAB_SLOTS \
+	((ENCPOOL_STR_SLAB_SIZE - sizeof(EncPool_Str_Slab)) / sizeof(EncPool_Str_Slot))
+
+/* Finger index (see encList_Str__setIndex() below).  The fingers are kept
+ * in a ring buffer, in list order.  Each one remembers a node, and its
+ * position in the list *minus* 'base': adding or removing a node at the head
+ * shifts every position by one, and that is done by changing 'base' alone.
+ *
+ * The index of a pooled list is malloc()ed like any other, but it is also
+ * linked onto the pool's list of indexes, so that freeing the pool frees it
+ * (the list itself need not be freed first).
+ */
+typedef struct EncList_Str_Finger EncList_Str_Finger;
+struct EncList_Str_Finger {
+	EncNode_Str	*node;
+	int		pos;
+};
+
+struct EncList_Str_Index {
+	EncList_Str_Finger	*fingers;
+	int			cap;		/* a power of 2 (or 0) */
+	int			first;
+	int			n;
+	int			base;
+	int			spacing;
+	int			valid;		/* if not, rebuild before use */
+
+	EncList_Str_Index	*nextPooled;	/* on pool->indexes */
+	EncList_Str_Index	*prevPooled;
+};
+
+typedef struct EncPool_Str_Chunk EncPool_Str_Chunk;
+struct EncPool_Str_Chunk {
+	EncPool_Str_Chunk	*next;
+	char			data[];
+};
+
+typedef struct EncPool_Str_Map EncPool_Str_Map;
+struct EncPool_Str_Map {
+	EncPool_Str_Map		*next;
+	void			*addr;
+	size_t			len;
+};
+
+struct EncapsulatedList_Str_Pool {
+	EncPool_Str_Slab	*slabs;		/* newest slab first */
+	int			used;		/* slots handed out from slabs->slots */
+	EncPool_Str_Slot	*freeSlots;
+
+	EncPool_Str_Chunk	*chunks;	/* string arena, newest chunk first */
+	size_t			chunkUsed;
+	size_t			chunkSize;
+
+	EncPool_Str_Map		*maps;		/* files mapped by mapFile() */
+	EncList_Str_Index	*indexes;	/* of the lists from allocPool() */
+};
+
+/* Interners (see encIntern_Str__alloc() below).  Each distinct string is
+ * kept once, in a buffer which starts with its hash and reference count; the
+ * nodes point at 'str', right after them.  The table itself is an open
+ * addressing (linear probing) array of slots, each of which keeps a copy of
+ * the hash, so that probing and growing never touch the buffers.
+ */
+typedef struct EncIntern_Str_Buf EncIntern_Str_Buf;
+struct EncIntern_Str_Buf {
+	EncIntern_Str	*intern;
+	uint64_t	hash;
+	unsigned int	refs;
+	unsigned int	len;
+	char		str[];
+};
+
+typedef struct EncIntern_Str_Slot EncIntern_Str_Slot;
+struct EncIntern_Str_Slot {
+	uint64_t		hash;
+	EncIntern_Str_Buf	*buf;		/* NULL if the slot is empty */
+};
+
+#define ENCINTERN_STR_MIN_SLOTS	1024
+
+struct EncapsulatedList_Str_Intern {
+	EncIntern_Str_Slot	*slots;
+	size_t			mask;		/* number of slots - 1 (a power of 2) */
+	size_t			used;		/* distinct strings */
+	int			freed;		/* free() was called; waiting for the last string */
+};
+
+/* Sort keys (see encKey_Str__allocNumeric() below) */
+#define ENCKEY_STR_NUMERIC	1
+#define ENCKEY_STR_FOLD		2
+#define ENCKEY_STR_FIELD	3
+#define ENCKEY_STR_CUSTOM	4
+
+struct EncapsulatedList_Str_Key {
+	int		kind;
+	char		sep;		/* FIELD: the separator, */
+	int		field;		/* ...the field number (from 1), */
+	EncKey_Str	*then;		/* ...and the key of the field (or NULL) */
+	EncKey_Str_Fn	fn;		/* CUSTOM */
+	void		*arg;
 };
 
-struct EncapsulatedList_Str_Node {
+/* While sortBy() (and the other ...By() methods) run, each node's 'str',
+ * 'len' and 'key' describe its extracted key instead of its string; they
+ * are saved in front of the key, which lives in a chain of chunks.
+ */
+#define ENCKEY_STR_CHUNK_SIZE	(256 * 1024)
+
+typedef struct EncKey_Str_Saved EncKey_Str_Saved;
+struct EncKey_Str_Saved {
 	char		*str;
-	int		dup;
-	EncNode_Str	*next;
-	EncNode_Str	*prev;
+	uint64_t	key;
+	unsigned int	len;
+	char		bytes[];	/* the extracted key */
 };
 
-/* Helpers for EncNode_Str */
-EncNode_Str *encNode_Str__alloc(char *string, int dup)
+typedef struct EncKey_Str_Arena EncKey_Str_Arena;
+struct EncKey_Str_Arena {
+	EncPool_Str_Chunk	*chunks;	/* newest chunk first */
+	size_t			used;
+	size_t			size;
+};
+
+// ------------- EncPool_Str (node and string pool) ---------------
+//
+// An optional pool for lists which hold a great many nodes.  A list which is
+// created with encList_Str__allocPool() takes its nodes (and its wrapper)
+// from large contiguous slabs owned by the pool, instead of calling malloc()
+// for each one; nodes which are freed go onto a free list and are reused.
+// Strings which are duplicated (dup=1) are copied into a "bump" arena of
+// large chunks, and are never freed one at a time.
+//
+// Any number of lists can share one pool; merge(), append() and splitAt()
+// work as usual between them (splitAt() allocates its new list from the same
+// pool).  Lists which use different pools - or a pool and malloc() - must
+// *NOT* be merged or appended to each other.
+//
+// Freeing the pool releases every node, string and list wrapper that was
+// allocated from it (and the finger indexes of those lists), in O(slabs)
+// rather than O(nodes), and unmaps any file loaded with
+// encList_Str__mapFile().  Those lists must not be used afterwards (and need
+// not be passed to encList_Str__free() first).
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None
+//
+// Allocates a new, empty pool.  No slabs are allocated until they are needed.
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+EncPool_Str *encPool_Str__alloc()
 {
-	EncNode_Str *node;
-	char *str = string;
+	EncPool_Str *pool;
 
-	if (!string) {
-		fprintf(stderr, "encNode_Str__alloc: The string is NULL.\n");
+	pool = (EncPool_Str *)malloc(sizeof(EncPool_Str));
+	if (!pool) {
+		perror("malloc");
 		return NULL;
 	}
+	ENCLIST_STR_STAT(mallocs, 1);
 
-	/* Allocate a new node */
-	node = (EncNode_Str *)malloc(sizeof(EncNode_Str));
-	if (!node) {
-		perror("malloc");
-		return NULL;
+	pool->slabs = NULL;
+	pool->used = 0;
+	pool->freeSlots = NULL;
+	pool->chunks = NULL;
+	pool->chunkUsed = 0;
+	pool->chunkSize = 0;
+	pool->maps = NULL;
+	pool->indexes = NULL;
+
+	return pool;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer (for the pool)
+//
+// Releases every slab, string chunk, mapping and finger index of the pool,
+// and the pool itself.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void encPool_Str__free(EncPool_Str *pool)
+{
+	EncPool_Str_Slab *slab, *nextSlab;
+	EncPool_Str_Chunk *chunk, *nextChunk;
+	EncPool_Str_Map *map, *nextMap;
+	EncList_Str_Index *idx, *nextIdx;
+
+	if (!pool) {
+		fprintf(stderr, "encPool_Str__free: The pool is NULL.\n");
+		return;
 	}
 
-	/* Duplicate the string if necessary */
-	if (dup) {
-		str = (char *)malloc(sizeof(char) * (strlen(string) + 1));
-		if (!str) {
+	for (slab = pool->slabs; slab; slab = nextSlab) {
+		nextSlab = slab->next;
+		free(slab);
+		ENCLIST_STR_STAT(frees, 1);
+	}
+	for (chunk = pool->chunks; chunk; chunk = nextChunk) {
+		nextChunk = chunk->next;
+		free(chunk);
+		ENCLIST_STR_STAT(frees, 1);
+	}
+	for (map = pool->maps; map; map = nextMap) {
+		nextMap = map->next;
+		munmap(map->addr, map->len);
+		free(map);
+		ENCLIST_STR_STAT(frees, 1);
+	}
+	for (idx = pool->indexes; idx; idx = nextIdx) {
+		nextIdx = idx->nextPooled;
+		if (idx->fingers)
+			ENCLIST_STR_STAT(frees, 1);
+		free(idx->fingers);
+		free(idx);
+		ENCLIST_STR_STAT(frees, 1);
+	}
+	free(pool);
+	ENCLIST_STR_STAT(frees, 1);
+}
+
+/* Returns an unused slot from the pool, or NULL if malloc() fails */
+static EncPool_Str_Slot *encPool_Str__allocSlot(EncPool_Str *pool)
+{
+	EncPool_Str_Slab *slab;
+	void *mem;
+	int err;
+
+	/* Reuse a slot that was given back */
+	if (pool->freeSlots) {
+		EncPool_Str_Slot *slot = pool->freeSlots;
+
+		pool->freeSlots = slot->nextFree;
+		return slot;
+	}
+
+	/* The current slab is full; add another one */
+	if (!pool->slabs || pool->used == ENCPOOL_STR_SLAB_SLOTS) {
+		err = posix_memalign(&mem, ENCPOOL_STR_SLAB_SIZE, ENCPOOL_STR_SLAB_SIZE);
+		if (err) {
+			fprintf(stderr, "posix_memalign: %s\n", strerror(err));
+			return NULL;
+		}
+		ENCLIST_STR_STAT(mallocs, 1);
+
+		slab = (EncPool_Str_Slab *)mem;
+		slab->pool = pool;
+		slab->next = pool->slabs;
+		pool->slabs = slab;
+		pool->used = 0;
+	}
+
+	return &pool->slabs->slots[pool->used++];
+}
+
+/* Gives a slot (from any slab of any pool) back to the pool that owns it */
+static void encPool_Str__freeSlot(void *ptr)
+{
+	EncPool_Str_Slab *slab;
+	EncPool_Str_Slot *slot = (EncPool_Str_Slot *)ptr;
+
+	slab = (EncPool_Str_Slab *)((uintptr_t)ptr & ~(uintptr_t)(ENCPOOL_STR_SLAB_SIZE - 1));
+	slot->nextFree = slab->pool->freeSlots;
+	slab->pool->freeSlots = slot;
+}
+
+/* Copies a string (of 'len' bytes, plus the NUL) into the pool's string
+ * arena, or returns NULL if malloc() fails.  Strings which do not fit in the
+ * current chunk start a new one; a string bigger than a whole chunk gets a
+ * chunk of its own.
+ */
+static char *encPool_Str__strdup(EncPool_Str *pool, char *string, size_t len)
+{
+	char *str;
+
+	len++;
+
+	if (pool->chunkSize - pool->chunkUsed < len) {
+		EncPool_Str_Chunk *chunk;
+		size_t size = len > ENCPOOL_STR_CHUNK_SIZE ? len : ENCPOOL_STR_CHUNK_SIZE;
+
+		chunk = (EncPool_Str_Chunk *)malloc(sizeof(EncPool_Str_Chunk) + size);
+		if (!chunk) {
 			perror("malloc");
-			/* Free the allocated node */
-			free(node);
 			return NULL;
 		}
-		strcpy(str, string);
+		ENCLIST_STR_STAT(mallocs, 1);
+
+		chunk->next = pool->chunks;
+		pool->chunks = chunk;
+		pool->chunkUsed = 0;
+		pool->chunkSize = size;
 	}
 
-	/* Initialize the node */
-	node->str = str;
-	node->dup = dup;
-	node->prev = NULL;
-	node->next = NULL;
+	str = pool->chunks->data + pool->chunkUsed;
+	pool->chunkUsed += len;
+	memcpy(str, string, len);
+	ENCLIST_STR_STAT(bytesDup, len);
 
-	return node;
+	return str;
 }
 
-void encNode_Str__free(EncNode_Str *node)
+// ------------- EncIntern_Str (string interner) ---------------
+//
+// An interner keeps one copy of each distinct string, shared by every node
+// which holds that string: for data with many repeats (millions of lines
+// with only a few thousand different values), that saves both the memory
+// for the copies and - since the nodes for equal strings then share a
+// pointer - most of the work of comparing them.
+//
+// A list uses an interner once it is given one with encList_Str__setIntern():
+// from then on, addHead(), addTail() and addTailN() with dup set look each
+// string up in the interner, and use the shared copy (adding it if this is
+// the first time).  Strings which are short enough to be copied into the
+// node itself are still copied there, since that costs no extra memory.
+// Each shared copy is freed along with the last node which uses it.
+//
+// One interner can be shared by any number of lists; but like the lists, it
+// must only be used by one thread at a time.  Lists from a pool cannot use
+// one: their nodes are not freed one by one, but all at once with the pool,
+// so the shared copies would never be let go of.
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None
+//
+// Allocates a new, empty interner.
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+EncIntern_Str *encIntern_Str__alloc()
 {
-	if (!node) {
-		fprintf(stderr, "encNode_Str__free: The node is NULL.\n");
-		return;
+	EncIntern_Str *intern;
+
+	intern = (EncIntern_Str *)malloc(sizeof(EncIntern_Str));
+	if (!intern) {
+		perror("malloc");
+		return NULL;
+	}
+	intern->slots = (EncIntern_Str_Slot *)calloc(ENCINTERN_STR_MIN_SLOTS, sizeof(EncIntern_Str_Slot));
+	if (!intern->slots) {
+		perror("calloc");
+		free(intern);
+		return NULL;
 	}
+	ENCLIST_STR_STAT(mallocs, 2);
 
-	/* Free the node without sanity check */
-	if (node->dup)
-		free(node->str);
-	free(node);
+	intern->mask = ENCINTERN_STR_MIN_SLOTS - 1;
+	intern->used = 0;
+	intern->freed = 0;
+
+	return intern;
 }
 
-void encNode_Str__addAfter(EncNode_Str *pos, EncNode_Str *node)
+// -------------- free() - Destructor ----------------
+// Parameters: interner
+//
+// Frees the interner.  If there are still nodes which use its strings, the
+// interner is actually freed along with the last of them (so it is safe to
+// call this before freeing the lists); in the meantime, it must not be
+// given to any more lists.
+//
+// count(): Returns the number of distinct strings in the interner.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error (and for count(), return -1).
+
+static void encIntern_Str__destroy(EncIntern_Str *intern)
 {
-	if (!pos || !node) {
-		fprintf(stderr, "encNode_Str__addAfter: The node(s) is NULL.\n");
+	free(intern->slots);
+	free(intern);
+	ENCLIST_STR_STAT(frees, 2);
+}
+
+void encIntern_Str__free(EncIntern_Str *intern)
+{
+	if (!intern) {
+		fprintf(stderr, "encIntern_Str__free: The interner is NULL.\n");
 		return;
 	}
 
-	/* Sanity check */
-	if (node->prev || node->next) {
-		fprintf(stderr, "encNode_Str__addAfter: The node is already on a list.\n");
+	intern->freed = 1;
+	if (!intern->used)
+		encIntern_Str__destroy(intern);
+}
+
+int encIntern_Str__count(EncIntern_Str *intern)
+{
+	if (!intern) {
+		fprintf(stderr, "encIntern_Str__count: The interner is NULL.\n");
+		return -1;
+	}
+
+	return (int)intern->used;
+}
+
+/* Hashes 'len' bytes, 8 at a time */
+static uint64_t encIntern_Str__hash(const char *str, size_t len)
+{
+	uint64_t hash = len * 0x9e3779b97f4a7c15ULL, word;
+
+	for (; len >= 8; str += 8, len -= 8) {
+		memcpy(&word, str, 8);
+		hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 32;
+	}
+	word = 0;
+	memcpy(&word, str, len);
+	hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+/* Doubles the number of slots.  The hashes are in the slots, so the strings
+ * are not looked at.  Returns 0 on success, or -1 if calloc() fails (and
+ * then the table is left as it was).
+ */
+static int encIntern_Str__grow(EncIntern_Str *intern)
+{
+	EncIntern_Str_Slot *slots;
+	size_t mask = intern->mask * 2 + 1, i, j;
+
+	slots = (EncIntern_Str_Slot *)calloc(mask + 1, sizeof(EncIntern_Str_Slot));
+	if (!slots) {
+		perror("calloc");
+		return -1;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	for (i = 0; i <= intern->mask; i++) {
+		if (!intern->slots[i].buf)
+			continue;
+		for (j = intern->slots[i].hash & mask; slots[j].buf; j = (j + 1) & mask)
+			;
+		slots[j] = intern->slots[i];
+	}
+
+	free(intern->slots);
+	ENCLIST_STR_STAT(frees, 1);
+	intern->slots = slots;
+	intern->mask = mask;
+	return 0;
+}
+
+/* Returns the shared copy of 'string' (which is 'len' bytes long), with one
+ * more reference to it - adding it to the table if it is not there yet.
+ * Returns NULL if the copy could not be allocated.
+ */
+static char *encIntern_Str__ref(EncIntern_Str *intern, char *string, size_t len)
+{
+	EncIntern_Str_Buf *buf;
+	uint64_t hash = encIntern_Str__hash(string, len);
+	size_t i;
+
+	for (i = hash & intern->mask; (buf = intern->slots[i].buf); i = (i + 1) & intern->mask) {
+		ENCLIST_STR_STAT(nodesWalked, 1);
+		if (intern->slots[i].hash == hash && buf->len == len &&
+		    !memcmp(buf->str, string, len)) {
+			buf->refs++;
+			return buf->str;
+		}
+	}
+
+	/* Not found; keep the table at most half full */
+	if ((intern->used + 1) * 2 > intern->mask + 1) {
+		if (encIntern_Str__grow(intern) < 0)
+			return NULL;
+		for (i = hash & intern->mask; intern->slots[i].buf; i = (i + 1) & intern->mask)
+			;
+	}
+
+	buf = (EncIntern_Str_Buf *)malloc(sizeof(EncIntern_Str_Buf) + len + 1);
+	if (!buf) {
+		perror("malloc");
+		return NULL;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+	ENCLIST_STR_STAT(bytesDup, len + 1);
+
+	buf->intern = intern;
+	buf->hash = hash;
+	buf->refs = 1;
+	buf->len = len;
+	memcpy(buf->str, string, len);
+	buf->str[len] = '\0';
+
+	intern->slots[i].hash = hash;
+	intern->slots[i].buf = buf;
+	intern->used++;
+	return buf->str;
+}
+
+/* Drops a reference to a shared string (as returned by ref()).  The last
+ * reference takes the string out of the table, and frees it - and the
+ * interner too, if it is waiting for that.
+ */
+static void encIntern_Str__unref(char *str)
+{
+	EncIntern_Str_Buf *buf = (EncIntern_Str_Buf *)(str - offsetof(EncIntern_Str_Buf, str));
+	EncIntern_Str *intern = buf->intern;
+	size_t i, j, home;
+
+	if (--buf->refs)
 		return;
+
+	for (i = buf->hash & intern->mask; intern->slots[i].buf != buf; i = (i + 1) & intern->mask)
+		;
+
+	/* Close the gap: move back any later entry in the same probe run that
+	 * could live in slot i (that is, whose home slot is not in (i, j])
+	 */
+	for (j = (i + 1) & intern->mask; intern->slots[j].buf; j = (j + 1) & intern->mask) {
+		home = intern->slots[j].hash & intern->mask;
+		if (((j - home) & intern->mask) >= ((j - i) & intern->mask)) {
+			intern->slots[i] = intern->slots[j];
+			i = j;
+		}
 	}
+	intern->slots[i].buf = NULL;
 
-	node->prev = pos;
-	node->next = pos->next;
-	if (pos->next)
-		pos->next->prev = node;
-	pos->next = node;
+	free(buf);
+	ENCLIST_STR_STAT(frees, 1);
+	if (!--intern->used && intern->freed)
+		encIntern_Str__destroy(intern);
 }
 
-/* Helpers for EncList_Str */
-EncNode_Str *encList_Str__popHead(EncList_Str *obj)
+/* Returns the first ENCNODE_STR_PREFIX bytes of a string of length 'len' as a
+ * big-endian integer, padded with zeros if the string is shorter
+ */
+static uint64_t encNode_Str__prefix(const char *str, size_t len)
 {
-	EncNode_Str *head;
+	unsigned char buf[ENCNODE_STR_PREFIX] = { 0 };
+	uint64_t key = 0;
+	int i;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__popHead: The object is NULL.\n");
+	memcpy(buf, str, len < ENCNODE_STR_PREFIX ? len : ENCNODE_STR_PREFIX);
+	for (i = 0; i < ENCNODE_STR_PREFIX; i++)
+		key = (key << 8) | buf[i];
+
+	return key;
+}
+
+/* Initializes a freshly allocated node to hold 'string', which is 'len'
+ * bytes long.  If dup is set, the string is copied: into the node itself if
+ * it is short enough, otherwise it is shared from the interner (if there is
+ * one), or copied into the pool's arena (for a pooled node) or a malloc()ed
+ * buffer.  If dup is not set, the node simply borrows the pointer - and then
+ * the string does not need a terminating NUL.
+ *
+ * Returns 0 on success, or -1 if the copy could not be allocated.
+ */
+static int encNode_Str__init(EncNode_Str *node, char *string, size_t len, int dup,
+                             EncPool_Str *pool, EncIntern_Str *intern)
+{
+	char *str = string;
+
+	node->flags = pool ? ENCNODE_STR_POOLED : 0;
+
+	/* Duplicate the string if necessary */
+	if (dup) {
+		if (len < ENCNODE_STR_INLINE) {
+			str = node->inl;
+			memcpy(str, string, len + 1);
+			ENCLIST_STR_STAT(bytesDup, len + 1);
+		} else if (intern) {
+			str = encIntern_Str__ref(intern, string, len);
+			if (!str)
+				return -1;
+			node->flags |= ENCNODE_STR_INTERNED;
+		} else if (pool) {
+			str = encPool_Str__strdup(pool, string, len);
+			if (!str)
+				return -1;
+		} else {
+			str = (char *)malloc(sizeof(char) * (len + 1));
+			if (!str) {
+				perror("malloc");
+				return -1;
+			}
+			memcpy(str, string, len + 1);
+			node->flags |= ENCNODE_STR_OWNED;
+			ENCLIST_STR_STAT(mallocs, 1);
+			ENCLIST_STR_STAT(bytesDup, len + 1);
+		}
+	}
+
+	/* Initialize the node */
+	node->str = str;
+	node->len = len;
+	node->key = encNode_Str__prefix(str, len);
+	node->prev = NULL;
+	node->next = NULL;
+
+	return 0;
+}
+
+/* Equivalent to encNode_Str__alloc(), but takes the node (and the copy of the
+ * string, if dup is set and it does not fit inline) from the pool - or the
+ * interner, if that is not NULL
+ */
+static EncNode_Str *encPool_Str__allocNode(EncPool_Str *pool, char *string, int dup,
+                                           EncIntern_Str *intern)
+{
+	EncNode_Str *node;
+
+	if (!string) {
+		fprintf(stderr, "encPool_Str__allocNode: The string is NULL.\n");
 		return NULL;
 	}
 
-	head = obj->head;
-	if (head) {
-		if (head->next)
-			head->next->prev = NULL;
-		obj->head = head->next;
+	node = (EncNode_Str *)encPool_Str__allocSlot(pool);
+	if (!node)
+		return NULL;
+
+	if (encNode_Str__init(node, string, strlen(string), dup, pool, intern) < 0) {
+		encPool_Str__freeSlot(node);
+		return NULL;
+	}
+
+	return node;
+}
+
+/* Equivalent to encNode_Str__alloc(), but shares the string from the
+ * interner (if it is not NULL)
+ */
+static EncNode_Str *encNode_Str__allocIntern(char *string, int dup, EncIntern_Str *intern)
+{
+	EncNode_Str *node;
+
+	if (!string) {
+		fprintf(stderr, "encNode_Str__alloc: The string is NULL.\n");
+		return NULL;
+	}
+
+	/* Allocate a new node */
+	node = (EncNode_Str *)malloc(sizeof(EncNode_Str));
+	if (!node) {
+		perror("malloc");
+		return NULL;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	if (encNode_Str__init(node, string, strlen(string), dup, NULL, intern) < 0) {
+		/* Free the allocated node */
+		free(node);
+		ENCLIST_STR_STAT(frees, 1);
+		return NULL;
+	}
+
+	return node;
+}
+
+/* Helpers for EncNode_Str */
+EncNode_Str *encNode_Str__alloc(char *string, int dup)
+{
+	return encNode_Str__allocIntern(string, dup, NULL);
+}
+
+/* Compares the strings of two nodes, with the same result as strcmp().
+ *
+ * Most comparisons are decided by the cached prefixes, with one integer
+ * compare, and without following either 'str' pointer.  On a tie, the first
+ * ENCNODE_STR_PREFIX bytes are known to be equal, so the cached lengths let
+ * this memcmp() just the rest.  (If either string is no longer than the
+ * prefix, equal prefixes mean the shorter string ends where the other one
+ * has a zero pad byte - so only the lengths are left to compare.)  Nodes
+ * which share their string (from an interner) are equal without even that.
+ *
+ * Building with -DENCLIST_STR_NO_PREFIX ignores the prefixes, and compares
+ * every pair of strings from their first byte; that is only there so that
+ * the benchmarks can measure what the prefixes save.
+ */
+static inline int encNode_Str__cmp(EncNode_Str *a, EncNode_Str *b)
+{
+	unsigned int len, skip;
+	int cmp;
+
+	ENCLIST_STR_STAT(compares, 1);
+#ifdef ENCLIST_STR_NO_PREFIX
+	skip = 0;
+#else
+	skip = ENCNODE_STR_PREFIX;
+	if (a->key != b->key)
+		return a->key < b->key ? -1 : 1;
+#endif
+	if (a->str == b->str)	/* the same (interned) string */
+		return 0;
+
+	len = a->len < b->len ? a->len : b->len;
+	if (len > skip) {
+		ENCLIST_STR_STAT(strcmps, 1);
+		cmp = memcmp(a->str + skip, b->str + skip, len - skip);
+		if (cmp)
+			return cmp;
+	}
+	return (a->len > b->len) - (a->len < b->len);
+}
+
+void encNode_Str__free(EncNode_Str *node)
+{
+	if (!node) {
+		fprintf(stderr, "encNode_Str__free: The node is NULL.\n");
+		return;
+	}
+
+	/* Free the node without sanity check */
+	if (node->flags & ENCNODE_STR_OWNED) {
+		free(node->str);
+		ENCLIST_STR_STAT(frees, 1);
+	} else if (node->flags & ENCNODE_STR_INTERNED)
+		encIntern_Str__unref(node->str);
+	if (node->flags & ENCNODE_STR_POOLED)
+		encPool_Str__freeSlot(node);
+	else if (node->flags & ENCNODE_STR_BATCH) {
+		EncList_Str_Batch *batch;
+
+		batch = (EncList_Str_Batch *)((char *)(node - (node->flags >> ENCNODE_STR_BATCH_SHIFT)) -
+		                              offsetof(EncList_Str_Batch, nodes));
+		if (!--batch->live) {
+			free(batch);
+			ENCLIST_STR_STAT(frees, 1);
+		}
+	} else {
+		free(node);
+		ENCLIST_STR_STAT(frees, 1);
+	}
+}
+
+void encNode_Str__addAfter(EncNode_Str *pos, EncNode_Str *node)
+{
+	if (!pos || !node) {
+		fprintf(stderr, "encNode_Str__addAfter: The node(s) is NULL.\n");
+		return;
+	}
+
+	/* Sanity check */
+	if (node->prev || node->next) {
+		fprintf(stderr, "encNode_Str__addAfter: The node is already on a list.\n");
+		return;
+	}
+
+	node->prev = pos;
+	node->next = pos->next;
+	if (pos->next)
+		pos->next->prev = node;
+	pos->next = node;
+}
+
+/* Helpers for EncList_Str */
+#define ENCLIST_STR_FINGER(idx, i) \
+	((idx)->fingers[((idx)->first + (i)) & ((idx)->cap - 1)])
+
+/* Makes room for one more finger; returns -1 (and leaves the index invalid)
+ * if that fails
+ */
+static int encList_Str__indexGrow(EncList_Str_Index *idx)
+{
+	EncList_Str_Finger *fingers;
+	int cap, i;
+
+	if (idx->n < idx->cap)
+		return 0;
+
+	cap = idx->cap ? idx->cap * 2 : 16;
+	fingers = (EncList_Str_Finger *)malloc(sizeof(EncList_Str_Finger) * cap);
+	if (!fingers) {
+		perror("malloc");
+		idx->valid = 0;
+		return -1;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	/* Unroll the ring into the new buffer */
+	for (i = 0; i < idx->n; i++)
+		fingers[i] = ENCLIST_STR_FINGER(idx, i);
+	if (idx->fingers)
+		ENCLIST_STR_STAT(frees, 1);
+	free(idx->fingers);
+	idx->fingers = fingers;
+	idx->cap = cap;
+	idx->first = 0;
+
+	return 0;
+}
+
+static void encList_Str__indexPushFront(EncList_Str_Index *idx, EncNode_Str *node, int pos)
+{
+	if (encList_Str__indexGrow(idx) < 0)
+		return;
+
+	idx->first = (idx->first - 1) & (idx->cap - 1);
+	idx->fingers[idx->first].node = node;
+	idx->fingers[idx->first].pos = pos - idx->base;
+	idx->n++;
+}
+
+static void encList_Str__indexPushBack(EncList_Str_Index *idx, EncNode_Str *node, int pos)
+{
+	if (encList_Str__indexGrow(idx) < 0)
+		return;
+
+	ENCLIST_STR_FINGER(idx, idx->n).node = node;
+	ENCLIST_STR_FINGER(idx, idx->n).pos = pos - idx->base;
+	idx->n++;
+}
+
+/* The list was reordered; the index will be rebuilt when it is next used */
+static void encList_Str__indexDirty(EncList_Str *obj)
+{
+	if (obj->index)
+		obj->index->valid = 0;
+}
+
+/* The list was emptied; an empty index is a valid one */
+static void encList_Str__indexClear(EncList_Str *obj)
+{
+	if (obj->index) {
+		obj->index->first = 0;
+		obj->index->n = 0;
+		obj->index->base = 0;
+		obj->index->valid = 1;
+	}
+}
+
+/* Frees the list's index (if it has one), and takes it off its pool */
+static void encList_Str__indexFree(EncList_Str *obj)
+{
+	EncList_Str_Index *idx = obj->index;
+
+	if (!idx)
+		return;
+
+	if (obj->pool) {
+		if (idx->prevPooled)
+			idx->prevPooled->nextPooled = idx->nextPooled;
+		else
+			obj->pool->indexes = idx->nextPooled;
+		if (idx->nextPooled)
+			idx->nextPooled->prevPooled = idx->prevPooled;
+	}
+
+	if (idx->fingers)
+		ENCLIST_STR_STAT(frees, 1);
+	free(idx->fingers);
+	free(idx);
+	ENCLIST_STR_STAT(frees, 1);
+	obj->index = NULL;
+}
+
+/* Puts one finger on every 'spacing'-th node, starting at the head.  If
+ * that fails, the index is left invalid (and index() just walks).
+ */
+static void encList_Str__indexRebuild(EncList_Str *obj)
+{
+	EncList_Str_Index *idx = obj->index;
+	EncNode_Str *node;
+	int pos;
+
+	encList_Str__indexClear(obj);
+	for (node = obj->head, pos = 0; node; node = node->next, pos++) {
+		ENCLIST_STR_STAT(nodesWalked, 1);
+		if (pos % idx->spacing == 0) {
+			encList_Str__indexPushBack(idx, node, pos);
+			if (!idx->valid)
+				return;
+		}
+	}
+}
+
+static EncNode_Str *encList_Str__allocNode(EncList_Str *obj, char *string, int dup)
+{
+	if (obj->pool)
+		return encPool_Str__allocNode(obj->pool, string, dup, obj->intern);
+	return encNode_Str__allocIntern(string, dup, obj->intern);
+}
+
+/* Links a chain of n nodes, first..last (already linked to each other),
+ * onto the tail of the list
+ */
+static void encList_Str__spliceTail(EncList_Str *obj, EncNode_Str *first, EncNode_Str *last, int n)
+{
+	first->prev = obj->tail;
+	if (obj->tail)
+		obj->tail->next = first;
+	else
+		obj->head = first;
+	obj->tail = last;
+	obj->count += n;
+	encList_Str__indexDirty(obj);
+}
+
+EncNode_Str *encList_Str__popHead(EncList_Str *obj)
+{
+	EncNode_Str *head;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__popHead: The object is NULL.\n");
+		return NULL;
+	}
+
+	head = obj->head;
+	if (head) {
+		if (head->next)
+			head->next->prev = NULL;
+		else	/* head was the only node */
+			obj->tail = NULL;
+		obj->head = head->next;
+		obj->count--;
+
+		/* Every position moves down by one */
+		if (obj->index && obj->index->valid) {
+			EncList_Str_Index *idx = obj->index;
+
+			if (idx->n && idx->fingers[idx->first].node == head) {
+				idx->first = (idx->first + 1) & (idx->cap - 1);
+				idx->n--;
+			}
+			idx->base--;
+		}
+
+		head->prev = NULL;
+		head->next = NULL;
+	}
+
+	return head;
+}
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None
+//
+// Allocates a new EncList_Str object, and initializes it to hold an empty
+// list (that is, no node objects should be allocated).
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+EncList_Str *encList_Str__alloc()
+{
+	EncList_Str *obj;
+
+	/* Allocate a new object */
+	obj = (EncList_Str *)malloc(sizeof(EncList_Str));
+	if (!obj) {
+	        perror("malloc");
+	        return NULL;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	/* Initialize the object */
+	obj->head = NULL;
+	obj->tail = NULL;
+	obj->count = 0;
+	obj->pool = NULL;
+	obj->index = NULL;
+	obj->intern = NULL;
+
+	return obj;
+}
+
+// ------------- allocPool() - Constructor ---------------
+// Parameters: pool
+//
+// Equivalent to alloc(), except that the new list (and every node that is
+// ever added to it) is allocated from the given pool.  See EncPool_Str above.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error and return NULL
+//   - malloc() fails.  Print error and return NULL
+
+EncList_Str *encList_Str__allocPool(EncPool_Str *pool)
+{
+	EncList_Str *obj;
+
+	if (!pool) {
+		fprintf(stderr, "encList_Str__allocPool: The pool is NULL.\n");
+		return NULL;
+	}
+
+	/* Allocate a new object */
+	obj = (EncList_Str *)encPool_Str__allocSlot(pool);
+	if (!obj)
+		return NULL;
+
+	/* Initialize the object */
+	obj->head = NULL;
+	obj->tail = NULL;
+	obj->count = 0;
+	obj->pool = pool;
+	obj->index = NULL;
+	obj->intern = NULL;
+
+	return obj;
+}
+
+// ------------- mapFile() - Constructor ---------------
+// Parameters: pool
+//             path of a text file
+//
+// Allocates a new list from the given pool, with one node for each line of
+// the file, in order.  The file is mmap()ed read-only, and each node simply
+// points at its line inside of the mapping - nothing is copied, and the only
+// memory allocated is one pool slot per line.  The mapping is never written
+// to, so its pages stay clean: they cost no memory of their own, and the
+// kernel can drop them (and read them again) whenever it needs to.  The
+// mapping belongs to the pool, and stays alive until the pool is freed; so
+// the nodes can be sorted, merged and split (with other lists from the same
+// pool) just like any others.
+//
+// NOTE: The strings are *NOT* terminated with a NUL; the newline is still
+//       there, just after the end of each one (and the last line may not
+//       have one at all).  Use encNode_Str__getLen() to find the length of
+//       each string, and never read past it.  The order of the strings is
+//       the same as if each line had been added with dup=1.
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error and return NULL
+//   - The file cannot be opened or mapped.  Print error and return NULL
+//   - malloc() fails.  Print error and return NULL
+
+/* Maps a whole file (read-only), and gives the mapping to the pool, which
+ * unmaps it when it is freed.  Returns the mapping (NULL, with *len == 0,
+ * for an empty file, which cannot be mapped), or MAP_FAILED if the file
+ * cannot be opened or mapped.
+ */
+static void *encPool_Str__mapFile(EncPool_Str *pool, char *path, size_t *len)
+{
+	EncPool_Str_Map *map;
+	struct stat st;
+	int fd;
+
+	*len = 0;
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		perror(path);
+		return MAP_FAILED;
+	}
+	if (fstat(fd, &st) < 0) {
+		perror(path);
+		close(fd);
+		return MAP_FAILED;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	map = (EncPool_Str_Map *)malloc(sizeof(EncPool_Str_Map));
+	if (!map) {
+		perror("malloc");
+		close(fd);
+		return MAP_FAILED;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+	map->len = st.st_size;
+	map->addr = mmap(NULL, map->len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map->addr == MAP_FAILED) {
+		perror("mmap");
+		free(map);
+		ENCLIST_STR_STAT(frees, 1);
+		return MAP_FAILED;
+	}
+	madvise(map->addr, map->len, MADV_SEQUENTIAL);
+
+	map->next = pool->maps;
+	pool->maps = map;
+
+	*len = map->len;
+	return map->addr;
+}
+
+/* Allocates room for 'n' nodes at once, as one anonymous mapping which is
+ * given to the pool (like a mapped file).  The mapping is cut into slabs
+ * just like the pool's own, so that its slots can be freed back to the pool
+ * one at a time - but they are not on the pool's list of slabs, since they
+ * were not malloc()ed.  Returns the first slab (the others follow it in
+ * memory), or NULL if mmap() fails.
+ */
+static EncPool_Str_Slab *encPool_Str__mapSlabs(EncPool_Str *pool, size_t n)
+{
+	EncPool_Str_Map *map;
+	EncPool_Str_Slab *slabs;
+	size_t nslabs, i;
+
+	map = (EncPool_Str_Map *)malloc(sizeof(EncPool_Str_Map));
+	if (!map) {
+		perror("malloc");
+		return NULL;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	/* One extra slab's worth, to line them up on their size */
+	nslabs = n / ENCPOOL_STR_SLAB_SLOTS + 1;
+	map->len = (nslabs + 1) * ENCPOOL_STR_SLAB_SIZE;
+	map->addr = mmap(NULL, map->len, PROT_READ | PROT_WRITE,
+	                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (map->addr == MAP_FAILED) {
+		perror("mmap");
+		free(map);
+		ENCLIST_STR_STAT(frees, 1);
+		return NULL;
+	}
+	map->next = pool->maps;
+	pool->maps = map;
+
+	slabs = (EncPool_Str_Slab *)(((uintptr_t)map->addr + ENCPOOL_STR_SLAB_SIZE - 1) &
+	                             ~(uintptr_t)(ENCPOOL_STR_SLAB_SIZE - 1));
+	for (i = 0; i < nslabs; i++) {
+		EncPool_Str_Slab *slab = (EncPool_Str_Slab *)((char *)slabs + i * ENCPOOL_STR_SLAB_SIZE);
+
+		slab->pool = pool;
+		slab->next = NULL;
+	}
+
+	return slabs;
+}
+
+EncList_Str *encList_Str__mapFile(EncPool_Str *pool, char *path)
+{
+	EncList_Str *obj;
+	EncNode_Str *node;
+	char *pos, *end, *nl;
+	size_t len;
+
+	if (!pool || !path) {
+		fprintf(stderr, "encList_Str__mapFile: The pool or path is NULL.\n");
+		return NULL;
+	}
+
+	obj = encList_Str__allocPool(pool);
+	/* Errors should be handled in encList_Str__allocPool */
+	if (!obj)
+		return NULL;
+
+	pos = (char *)encPool_Str__mapFile(pool, path, &len);
+	if (pos == MAP_FAILED) {
+		encList_Str__free(obj);
+		return NULL;
+	}
+	/* An empty file is an empty list */
+	if (!pos)
+		return obj;
+
+	/* One node per line; a last line without a newline still counts */
+	end = pos + len;
+	while (pos < end) {
+		nl = (char *)memchr(pos, '\n', end - pos);
+		if (!nl)
+			nl = end;
+
+		node = (EncNode_Str *)encPool_Str__allocSlot(pool);
+		if (!node) {
+			encList_Str__free(obj);
+			return NULL;
+		}
+		encNode_Str__init(node, pos, nl - pos, 0, pool, NULL);
+
+		node->prev = obj->tail;
+		if (obj->tail)
+			obj->tail->next = node;
+		else
+			obj->head = node;
+		obj->tail = node;
+		obj->count++;
+
+		pos = nl + 1;
+	}
+
+	return obj;
+}
+
+// ---------------- save ---------------------------------
+// Parameters: 'this' pointer (for the wrapper object)
+//             path of the file to write
+//
+// Writes the list to a binary "snapshot" file, which load() (below) can
+// turn back into a list far faster than re-reading and re-adding every
+// string.  The file holds, in order:
+//
+//   - a header: ENCLIST_STR_FILE_MAGIC, the number of strings, and the size
+//     of the blob;
+//   - a table with one entry per string, in list order: the offset of the
+//     string in the blob, its length, and its cached key prefix;
+//   - the blob: each string, as a 4-byte length, then the bytes, then a
+//     NUL.
+//
+// The table is everything that load() needs to rebuild the nodes, so it
+// never has to read the blob; the length prefixes make the blob readable on
+// its own, too.  Numbers are written in the machine's own byte order (the
+// magic number is followed by a check value, so that a file from a machine
+// with the other byte order is rejected).
+//
+// Returns 0 on success, or -1 on an error (the file may then be left half
+// written).
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error and return -1.
+//   - The file cannot be written.  Print error and return -1.
+
+#define ENCLIST_STR_FILE_MAGIC	"ENCLSTR1"
+#define ENCLIST_STR_FILE_ORDER	0x0102030405060708ULL
+
+typedef struct EncList_Str_FileHdr EncList_Str_FileHdr;
+struct EncList_Str_FileHdr {
+	char		magic[8];
+	uint64_t	order;		/* ENCLIST_STR_FILE_ORDER */
+	uint64_t	count;
+	uint64_t	blobSize;
+};
+
+typedef struct EncList_Str_FileEntry EncList_Str_FileEntry;
+struct EncList_Str_FileEntry {
+	uint64_t	key;
+	uint64_t	offset;		/* of the string itself (after its length) */
+	uint64_t	len;
+};
+
+int encList_Str__save(EncList_Str *obj, char *path)
+{
+	EncList_Str_FileHdr hdr;
+	EncList_Str_FileEntry entry;
+	EncNode_Str *node;
+	FILE *tableFp, *blobFp;
+	uint32_t len;
+	int err = 0;
+
+	if (!obj || !path) {
+		fprintf(stderr, "encList_Str__save: The object or path is NULL.\n");
+		return -1;
+	}
+
+	/* The table and the blob are written in the same walk (after a sort,
+	 * the nodes are scattered all over memory, so a walk is expensive),
+	 * through two streams on the same file: one starting at the table, and
+	 * one at the blob, which starts right after it.
+	 */
+	blobFp = fopen(path, "wb");
+	tableFp = blobFp ? fopen(path, "r+b") : NULL;
+	if (!tableFp) {
+		perror(path);
+		if (blobFp)
+			fclose(blobFp);
+		return -1;
+	}
+	setvbuf(tableFp, NULL, _IOFBF, 1 << 20);
+	setvbuf(blobFp, NULL, _IOFBF, 1 << 20);
+
+	memcpy(hdr.magic, ENCLIST_STR_FILE_MAGIC, sizeof(hdr.magic));
+	hdr.order = ENCLIST_STR_FILE_ORDER;
+	hdr.count = obj->count;
+	hdr.blobSize = 0;
+	err |= fseeko(tableFp, sizeof(hdr), SEEK_SET) < 0;
+	err |= fseeko(blobFp, sizeof(hdr) + hdr.count * sizeof(entry), SEEK_SET) < 0;
+
+	/* (The strings from mapFile() have no NUL of their own, so the length
+	 * is what counts.)
+	 */
+	for (node = obj->head; node && !err; node = node->next) {
+		entry.key = node->key;
+		entry.offset = hdr.blobSize + sizeof(len);
+		entry.len = node->len;
+		err |= fwrite(&entry, sizeof(entry), 1, tableFp) != 1;
+
+		len = node->len;
+		err |= fwrite(&len, sizeof(len), 1, blobFp) != 1;
+		err |= fwrite(node->str, 1, node->len, blobFp) != node->len;
+		err |= fputc('\0', blobFp) == EOF;
+		hdr.blobSize += sizeof(len) + node->len + 1;
+	}
+
+	/* The header goes last, once the size of the blob is known */
+	err |= fseeko(tableFp, 0, SEEK_SET) < 0;
+	err |= fwrite(&hdr, sizeof(hdr), 1, tableFp) != 1;
+
+	if (fclose(tableFp) != 0)
+		err = 1;
+	if (fclose(blobFp) != 0)
+		err = 1;
+	if (err) {
+		perror(path);
+		return -1;
+	}
+	return 0;
+}
+
+// ------------- load() - Constructor ---------------
+// Parameters: pool
+//             path of a file written by save()
+//
+// Allocates a new list from the given pool, holding the strings saved in the
+// file, in the same order.  Just like mapFile(), the file is mmap()ed, and
+// belongs to the pool until the pool is freed; each node simply points at
+// its string inside of the mapping (as if it had been added with dup=0).
+//
+// The nodes are rebuilt in one pass over the table, from the lengths and
+// key prefixes saved there.  The nodes all come from one big block, which is
+// mapped (and faulted in) all at once, rather than slab by slab.  Unlike
+// mapFile(), the strings are terminated with a NUL (which save() wrote).
+//
+// Nothing in the file is trusted: every table entry is checked against the
+// blob - that its string lies inside of it, after a length prefix which
+// matches, with a NUL right after it, and that its key prefix is the one
+// computed from its bytes - before the node is built.  So the blob is read
+// once, front to back, along with the table.
+//
+// If the file is rejected (or malloc() fails), the list is freed, but the
+// mapping of the file and the block of nodes stay with the pool until the
+// pool itself is freed.
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error and return NULL
+//   - The file cannot be opened or mapped, or is not a (complete, and
+//     consistent) file from save().  Print error and return NULL
+//   - malloc() fails.  Print error and return NULL
+
+EncList_Str *encList_Str__load(EncPool_Str *pool, char *path)
+{
+	EncList_Str *obj;
+	EncList_Str_FileHdr hdr;
+	EncList_Str_FileEntry *table;
+	EncPool_Str_Slab *slabs;
+	EncNode_Str *node;
+	char *addr, *blob, *str;
+	size_t len, used = 0;
+	uint32_t strLen;
+	uint64_t i;
+
+	if (!pool || !path) {
+		fprintf(stderr, "encList_Str__load: The pool or path is NULL.\n");
+		return NULL;
+	}
+
+	addr = (char *)encPool_Str__mapFile(pool, path, &len);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	/* Check everything that the loop below depends on, up front */
+	if (len >= sizeof(hdr))
+		memcpy(&hdr, addr, sizeof(hdr));
+	if (len < sizeof(hdr) || memcmp(hdr.magic, ENCLIST_STR_FILE_MAGIC, sizeof(hdr.magic)) ||
+	    hdr.order != ENCLIST_STR_FILE_ORDER || hdr.count > INT32_MAX ||
+	    (len - sizeof(hdr)) / sizeof(EncList_Str_FileEntry) < hdr.count ||
+	    len - sizeof(hdr) - hdr.count * sizeof(EncList_Str_FileEntry) != hdr.blobSize) {
+		fprintf(stderr, "encList_Str__load: %s is not a list snapshot.\n", path);
+		return NULL;
+	}
+	table = (EncList_Str_FileEntry *)(addr + sizeof(hdr));
+	blob = (char *)(table + hdr.count);
+
+	obj = encList_Str__allocPool(pool);
+	/* Errors should be handled in encList_Str__allocPool */
+	if (!obj)
+		return NULL;
+
+	slabs = encPool_Str__mapSlabs(pool, hdr.count);
+	if (!slabs) {
+		encList_Str__free(obj);
+		return NULL;
+	}
+
+	for (i = 0; i < hdr.count; i++) {
+		if (table[i].offset < sizeof(strLen) || table[i].offset > hdr.blobSize ||
+		    table[i].len >= hdr.blobSize - table[i].offset || table[i].len > UINT32_MAX) {
+			fprintf(stderr, "encList_Str__load: %s is not a list snapshot.\n", path);
+			encList_Str__free(obj);
+			return NULL;
+		}
+		str = blob + table[i].offset;
+		memcpy(&strLen, str - sizeof(strLen), sizeof(strLen));
+		if (strLen != table[i].len || str[table[i].len] != '\0' ||
+		    table[i].key != encNode_Str__prefix(str, table[i].len)) {
+			fprintf(stderr, "encList_Str__load: %s is corrupt (string %llu).\n", path,
+			        (unsigned long long)i);
+			encList_Str__free(obj);
+			return NULL;
+		}
+
+		node = &slabs->slots[used++].node;
+		if (used == ENCPOOL_STR_SLAB_SLOTS) {
+			slabs = (EncPool_Str_Slab *)((char *)slabs + ENCPOOL_STR_SLAB_SIZE);
+			used = 0;
+		}
+		node->str = str;
+		node->len = table[i].len;
+		node->key = table[i].key;
+		node->flags = ENCNODE_STR_POOLED;
+		node->next = NULL;
+
+		node->prev = obj->tail;
+		if (obj->tail)
+			obj->tail->next = node;
+		else
+			obj->head = node;
+		obj->tail = node;
+	}
+	obj->count = hdr.count;
+
+	return obj;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer (for the wrapper object)
+//
+// Frees an existing EncList_Str object.  If there are any nodes inside this
+// list, this also frees all of them.  (For a list from a pool, the nodes are
+// given back to the pool; encPool_Str__free() releases them all at once.)
+//
+// ERRORS:
+//   - Pointer is NULL
+
+void encList_Str__free(EncList_Str *obj)
+{
+	EncNode_Str *pos, *next;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__free: The object is NULL.\n");
+		return;
+	}
+	ENCLIST_STR_BEGIN();
+
+	/* Free nodes */
+	pos = obj->head;
+	while (pos) {
+		next = pos->next;
+		encNode_Str__free(pos);
+		pos = next;
+	}
+
+	encList_Str__indexFree(obj);
+
+	/* Free the object itself */
+	if (obj->pool)
+		encPool_Str__freeSlot(obj);
+	else {
+		free(obj);
+		ENCLIST_STR_STAT(frees, 1);
+	}
+	ENCLIST_STR_END("free");
+}
+
+// ---------------- addHead ---------------------------------
+// Parameters: 'this' pointer (for the wrapper object)
+//             *string*
+//             dup (boolean flag)
+//
+// Adds the given string to the front of the list (duplicates are allowed).  If
+// dup=1, then this method will copy the string: strings shorter than
+// ENCNODE_STR_INLINE are stored inside the node itself, and longer ones get a
+// malloc()ed buffer.  If dup=0, it will simply save the pointer into the node
+// (the string must not change while it is on the list).
+//
+// When the node is destroyed later, free() will free the string if it was
+// duplicated in this function - but if it was not duplicated, then it will
+// *NOT* free it, and the caller is responsible for doing so.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void encList_Str__addHead(EncList_Str *obj, char *string, int dup)
+{
+	EncNode_Str *node;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__addHead: The object is NULL.\n");
+		return;
+	}
+
+	/* Allocate a new node */
+	node = encList_Str__allocNode(obj, string, dup);
+	/* Errors should be handled in encList_Str__allocNode */
+	if (!node)
+		return;
+
+	/* Add to the front of the list */
+	node->prev = NULL;
+	node->next = obj->head;
+	if (obj->head)
+		obj->head->prev = node;
+	else	/* the list was empty */
+		obj->tail = node;
+	obj->head = node;
+	obj->count++;
+
+	/* Every position moves up by one; add a finger if the first one is
+	 * now too far from the head
+	 */
+	if (obj->index && obj->index->valid) {
+		EncList_Str_Index *idx = obj->index;
+
+		idx->base++;
+		if (!idx->n || idx->fingers[idx->first].pos + idx->base >= idx->spacing)
+			encList_Str__indexPushFront(idx, node, 0);
+	}
+}
+
+// ---------------- addTail ---------------------------------
+// Parameters: 'this' pointer (for the wrapper object)
+//             *string*
+//             dup (boolean flag)
+//
+// Adds the given string to the end of the list (duplicates are allowed).  If
+// dup=1, then this method will copy the string: strings shorter than
+// ENCNODE_STR_INLINE are stored inside the node itself, and longer ones get a
+// malloc()ed buffer.  If dup=0, it will simply save the pointer into the node
+// (the string must not change while it is on the list).
+//
+// When the node is destroyed later, free() will free the string if it was
+// duplicated in this function - but if it was not duplicated, then it will
+// *NOT* free it, and the caller is responsible for doing so.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void encList_Str__addTail(EncList_Str *obj, char *string, int dup)
+{
+	EncNode_Str *node;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__addTail: The object is NULL.\n");
+		return;
+	}
+
+	/* Allocate a new node */
+	node = encList_Str__allocNode(obj, string, dup);
+	/* Errors should be handled in encList_Str__allocNode */
+	if (!node)
+		return;
+
+	/* Add to the end of the list */
+	if (!obj->tail)
+		obj->head = node;
+	else {
+		node->prev = obj->tail;
+		obj->tail->next = node;
+	}
+	obj->tail = node;
+	obj->count++;
+
+	/* Add a finger if the last one is now too far from the tail */
+	if (obj->index && obj->index->valid) {
+		EncList_Str_Index *idx = obj->index;
+
+		if (!idx->n ||
+		    obj->count - 1 - (ENCLIST_STR_FINGER(idx, idx->n - 1).pos + idx->base) >= idx->spacing)
+			encList_Str__indexPushBack(idx, node, obj->count - 1);
+	}
+}
+
+// ---------------- addTailN ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             array of strings
+//             n (the number of strings)
+//             dup
+//
+// Equivalent to calling addTail() once for each string, in order; but all
+// of the nodes - and the copies of the strings which don't fit in a node,
+// if dup is set - are allocated as one block (one per ENCLIST_STR_BATCH_MAX
+// strings), initialized and linked to each other in one pass, and then
+// linked onto the tail all at once.
+//
+// The nodes are ordinary nodes in every other way: they can be moved to
+// other lists, and freed one at a time.  The block itself is freed along
+// with the last of its nodes.  For a list with a pool, the nodes simply come
+// from the pool, as they would for addTail().
+//
+// ERRORS:
+//   - Pointer is NULL, n < 0, or one of the strings is NULL.  Print error;
+//     the list is not changed.
+//   - malloc() fails.  Print error; the list is not changed.
+
+/* Allocates and links one batch of nodes, for strings[0..n) (n > 0).  With
+ * an interner, the strings which don't fit inline are shared from it, rather
+ * than copied into the batch.
+ */
+static int encList_Str__allocBatch(char **strings, int n, int dup, EncIntern_Str *intern,
+                                   EncNode_Str **first, EncNode_Str **last)
+{
+	EncList_Str_Batch *batch;
+	EncNode_Str *node;
+	size_t bytes = 0, len;
+	char *area;
+	int i;
+
+	/* Room for the copies of the strings that won't fit inline */
+	if (dup && !intern) {
+		for (i = 0; i < n; i++) {
+			len = strlen(strings[i]);
+			if (len >= ENCNODE_STR_INLINE)
+				bytes += len + 1;
+		}
+	}
+
+	if (posix_memalign((void **)&batch, 64,
+	                   offsetof(EncList_Str_Batch, nodes) + sizeof(EncNode_Str) * n + bytes)) {
+		perror("posix_memalign");
+		return -1;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+	batch->live = n;
+	area = (char *)&batch->nodes[n];
+
+	for (i = 0; i < n; i++) {
+		node = &batch->nodes[i];
+		len = strlen(strings[i]);
+
+		node->flags = ENCNODE_STR_BATCH | (i << ENCNODE_STR_BATCH_SHIFT);
+		node->str = strings[i];
+		if (dup && intern && len >= ENCNODE_STR_INLINE) {
+			node->str = encIntern_Str__ref(intern, strings[i], len);
+			if (!node->str) {
+				while (i--) {
+					if (batch->nodes[i].flags & ENCNODE_STR_INTERNED)
+						encIntern_Str__unref(batch->nodes[i].str);
+				}
+				free(batch);
+				ENCLIST_STR_STAT(frees, 1);
+				return -1;
+			}
+			node->flags |= ENCNODE_STR_INTERNED;
+		} else if (dup) {
+			node->str = len < ENCNODE_STR_INLINE ? node->inl : area;
+			memcpy(node->str, strings[i], len + 1);
+			ENCLIST_STR_STAT(bytesDup, len + 1);
+			if (len >= ENCNODE_STR_INLINE)
+				area += len + 1;
+		}
+		node->len = len;
+		node->key = encNode_Str__prefix(node->str, len);
+		node->prev = i ? node - 1 : NULL;
+		node->next = node + 1;
+	}
+	batch->nodes[n - 1].next = NULL;
+
+	*first = &batch->nodes[0];
+	*last = &batch->nodes[n - 1];
+	return 0;
+}
+
+void encList_Str__addTailN(EncList_Str *obj, char **strings, int n, int dup)
+{
+	EncNode_Str *first = NULL, *last = NULL, *head, *tail, *node;
+	int i, size;
+
+	if (!obj || !strings || n < 0) {
+		fprintf(stderr, "encList_Str__addTailN: The object or strings are NULL, or n is negative.\n");
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		if (!strings[i]) {
+			fprintf(stderr, "encList_Str__addTailN: The string is NULL.\n");
+			return;
+		}
+	}
+	ENCLIST_STR_BEGIN();
+
+	/* Build the whole chain first, so that a failure leaves the list alone */
+	for (i = 0; i < n; i += size) {
+		if (obj->pool) {
+			size = 1;
+			head = tail = encPool_Str__allocNode(obj->pool, strings[i], dup, obj->intern);
+		} else {
+			size = n - i < ENCLIST_STR_BATCH_MAX ? n - i : ENCLIST_STR_BATCH_MAX;
+			if (encList_Str__allocBatch(strings + i, size, dup, obj->intern, &head, &tail) < 0)
+				head = NULL;
+		}
+
+		/* Give back whatever was built so far */
+		if (!head) {
+			for (node = first; node; node = first) {
+				first = node->next;
+				node->prev = NULL;
+				node->next = NULL;
+				encNode_Str__free(node);
+			}
+			ENCLIST_STR_END("addTailN");
+			return;
+		}
+
+		if (last) {
+			last->next = head;
+			head->prev = last;
+		} else
+			first = head;
+		last = tail;
+	}
+
+	/* Splice the whole chain onto the tail at once */
+	if (first)
+		encList_Str__spliceTail(obj, first, last, n);
+	ENCLIST_STR_END("addTailN");
+}
+
+// ---------------- count ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Returns the number of nodes in the list.  The count is maintained by every
+// method which adds or removes nodes, so this is O(1).
+//
+// ERRORS:
+//   'this' is NULL.  Print error and return -1.
+
+int encList_Str__count(EncList_Str *obj)
+{
+	if (!obj) {
+		fprintf(stderr, "encList_Str__count: The object is NULL.\n");
+		return 0;
+	}
+
+	return obj->count;
+}
+
+// ---------------- getMin/getMax ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Searches the list for the minimum or maximum string.  This does *NOT*
+// assume that the list is sorted, and so it probably will perform a
+// brute-force scan of the entire list.
+//
+// Returns NULL if the list is empty.  For a list from mapFile(), the string
+// is not terminated with a NUL; to read it, find its node (by walking the
+// list), and use encNode_Str__getLen().
+//
+// ERRORS:
+//   'this' is NULL.  Print error and return NULL.
+
+char *encList_Str__getMin(EncList_Str *obj)
+{
+	EncNode_Str *node, *min;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__getMin: The object is NULL.\n");
+		return 0;
+	}
+
+	if (!obj->head)
+		return NULL;
+
+	ENCLIST_STR_BEGIN();
+	min = obj->head;
+	for (node = min->next; node; node = node->next) {
+		ENCLIST_STR_STAT(nodesWalked, 1);
+		if (encNode_Str__cmp(min, node) > 0)
+			min = node;
+	}
+	ENCLIST_STR_END("getMin");
+
+	return min->str;
+}
+char *encList_Str__getMax(EncList_Str *obj)
+{
+	EncNode_Str *node, *max;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__getMax: The object is NULL.\n");
+		return 0;
+	}
+
+	if (!obj->head)
+		return NULL;
+
+	ENCLIST_STR_BEGIN();
+	max = obj->head;
+	for (node = max->next; node; node = node->next) {
+		ENCLIST_STR_STAT(nodesWalked, 1);
+		if (encNode_Str__cmp(max, node) < 0)
+			max = node;
+	}
+	ENCLIST_STR_END("getMax");
+
+	return max->str;
+}
+
+// ---------------- sort ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             another list
+//
+// This function assumes (but does not verify) that the two lists are both
+// already sorted.  It iterates through the two lists in parallel, always
+// taking the smaller value from each list and placing into the resulting,
+// merged list.
+//
+// Thus, the resulting list will be sorted when the function completes.
+//
+// The merged list will be stored in the first parameter; all of the nodes
+// will be removed from the second parameter (and placed in their proper
+// locations within the first).
+//
+// EXAMPLE:
+//   Before merge():
+//       left  list: foo jkl qwerty
+//       right list: asdf bar good zzzz
+//   After merge():
+//       left  list: asdf bar foo good jkl qwerty zzzz
+//       right list: <empty>
+//
+// NOTE: Strings must *NOT* be copied back and forth between nodes!
+//       This function *ONLY* changes the next/prev arrows that link nodes!
+//
+// ERRORS:
+//   Either pointer is NULL.  Print error.
+
+void encList_Str__merge(EncList_Str *lhs, EncList_Str *rhs)
+{
+	EncList_Str obj = { NULL, NULL, 0, NULL, NULL, NULL };
+	EncNode_Str *left, *right, *node;
+
+	if (!lhs || !rhs) {
+		fprintf(stderr, "encList_Str__merge: The object is NULL.\n");
+		return;
+	}
+	ENCLIST_STR_BEGIN();
+
+	/* Start from heads of two lists */
+	left = lhs->head;
+	right = rhs->head;
+	while (left && right) {
+		/* Take the minimum node; ties go to lhs to keep the merge stable */
+		if (encNode_Str__cmp(left, right) <= 0) {
+			node = left;
+			left = left->next;
+		} else {
+			node = right;
+			right = right->next;
+		}
+
+		/* Link onto the end of the temporary list */
+		node->prev = obj.tail;
+		if (obj.tail)
+			obj.tail->next = node;
+		else
+			obj.head = node;
+		obj.tail = node;
+	}
+
+	/* Link the rest of the list that has not yet been fully merged; its
+	 * nodes are already chained together, so only the first one moves.
+	 */
+	node = left ? left : right;
+	if (node) {
+		node->prev = obj.tail;
+		if (obj.tail)
+			obj.tail->next = node;
+		else
+			obj.head = node;
+		obj.tail = left ? lhs->tail : rhs->tail;
+	}
+	obj.count = lhs->count + rhs->count;
+
+	/* Assign the merged list to lhs, and empty rhs */
+	lhs->head = obj.head;
+	lhs->tail = obj.tail;
+	lhs->count = obj.count;
+	rhs->head = NULL;
+	rhs->tail = NULL;
+	rhs->count = 0;
+	encList_Str__indexDirty(lhs);
+	encList_Str__indexClear(rhs);
+	ENCLIST_STR_END("merge");
+}
+
+// ---------------- mergeK ----------------------------
+// Parameters: array of pointers to lists
+//             number of lists in the array
+//
+// Just like merge(), but merges any number of sorted lists at once.  The
+// merged list is stored in the first list of the array; all of the other
+// lists will be empty afterwards.  Ties are broken by position in the array
+// (a node from lists[i] comes before an equal node from lists[j] if i < j),
+// so merging consecutive pieces of a list keeps equal strings in order.
+//
+// The lists are merged with a "loser tree" (a tournament tree which keeps
+// the loser of each match in its internal nodes).  The winner - the smallest
+// head of any list - is moved to the output, and only the matches along the
+// path from its leaf to the root are replayed; so each node costs about
+// log2(K) comparisons, and is touched only once, instead of once for every
+// level of a chain of pairwise merges.  When only one list is left, the rest
+// of it is linked in all at once.
+//
+// NOTE: Just like merge(), nodes are relinked; strings are never copied.
+//
+// ERRORS:
+//   - The array, or any of the lists, is NULL.  Print error.
+//   - malloc() fails.  Print error, and fall back to pairwise merges.
+
+/* Does the head of list a beat the head of list b?  An empty list never
+ * wins, and ties go to the list with the smaller index.
+ */
+static int encList_Str__beats(EncNode_Str **cur, int a, int b)
+{
+	int cmp;
+
+	if (!cur[a])
+		return 0;
+	if (!cur[b])
+		return 1;
+
+	cmp = encNode_Str__cmp(cur[a], cur[b]);
+	return cmp < 0 || (cmp == 0 && a < b);
+}
+
+void encList_Str__mergeK(EncList_Str **lists, int k)
+{
+	EncNode_Str **cur;
+	EncNode_Str *head = NULL, *tail = NULL, *node;
+	int *tree, *win;
+	int i, t, w, live = 0, count = 0;
+
+	if (!lists || k < 1) {
+		fprintf(stderr, "encList_Str__mergeK: The array is NULL or empty.\n");
+		return;
+	}
+	for (i = 0; i < k; i++) {
+		if (!lists[i]) {
+			fprintf(stderr, "encList_Str__mergeK: The object is NULL.\n");
+			return;
+		}
+	}
+	ENCLIST_STR_BEGIN();
+
+	cur = (EncNode_Str **)malloc(sizeof(EncNode_Str *) * k);
+	tree = (int *)malloc(sizeof(int) * 3 * k);
+	if (!cur || !tree) {
+		perror("malloc");
+		ENCLIST_STR_STAT(mallocs, !!cur + !!tree);
+		ENCLIST_STR_STAT(frees, !!cur + !!tree);
+		free(cur);
+		free(tree);
+
+		/* Pairwise, in order, so that ties still go to the lower index */
+		for (t = 1; t < k; t *= 2) {
+			for (i = 0; i + t < k; i += 2 * t)
+				encList_Str__merge(lists[i], lists[i + t]);
+		}
+		ENCLIST_STR_END("mergeK");
+		return;
+	}
+	ENCLIST_STR_STAT(mallocs, 2);
+	win = tree + k;
+
+	for (i = 0; i < k; i++) {
+		cur[i] = lists[i]->head;
+		count += lists[i]->count;
+		if (cur[i])
+			live++;
+	}
+
+	/* Play the first tournament, bottom-up: the leaves are win[k..2k-1],
+	 * and each internal node t keeps the loser of its match in tree[t]
+	 */
+	for (i = 0; i < k; i++)
+		win[k + i] = i;
+	for (t = k - 1; t > 0; t--) {
+		int a = win[2 * t], b = win[2 * t + 1];
+
+		if (encList_Str__beats(cur, a, b)) {
+			win[t] = a;
+			tree[t] = b;
+		} else {
+			win[t] = b;
+			tree[t] = a;
+		}
+	}
+	w = k > 1 ? win[1] : 0;
+
+	while (live > 1) {
+		/* Move the winner to the output */
+		node = cur[w];
+		cur[w] = node->next;
+		if (!cur[w])
+			live--;
+
+		node->prev = tail;
+		if (tail)
+			tail->next = node;
+		else
+			head = node;
+		tail = node;
+
+		/* Replay the matches on the path from the winner's leaf */
+		for (t = (w + k) / 2; t > 0; t /= 2) {
+			if (encList_Str__beats(cur, tree[t], w)) {
+				int loser = w;
+
+				w = tree[t];
+				tree[t] = loser;
+			}
+		}
+	}
+
+	/* Link the rest of the only list that is left (if any) */
+	for (i = 0; live && i < k; i++) {
+		if (!cur[i])
+			continue;
+
+		cur[i]->prev = tail;
+		if (tail)
+			tail->next = cur[i];
+		else
+			head = cur[i];
+		tail = lists[i]->tail;
+	}
+
+	for (i = 0; i < k; i++) {
+		lists[i]->head = NULL;
+		lists[i]->tail = NULL;
+		lists[i]->count = 0;
+		encList_Str__indexClear(lists[i]);
+	}
+	lists[0]->head = head;
+	lists[0]->tail = tail;
+	lists[0]->count = count;
+	encList_Str__indexDirty(lists[0]);
+
+	free(cur);
+	free(tree);
+	ENCLIST_STR_STAT(frees, 2);
+	ENCLIST_STR_END("mergeK");
+}
+
+// ---------------- unique ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Removes (and frees) every node whose string is equal to the one before
+// it, so that a sorted list is left with just one node for each distinct
+// string - the first of its run.  (On a list which is not sorted, this only
+// removes the duplicates which happen to be next to each other, just like
+// uniq(1).)
+//
+// Returns the number of nodes removed.
+//
+// group(): Equivalent, but also counts the nodes in each run, like
+// "uniq -c".  *counts is set to a malloc()ed array, in which counts[i] is the
+// size of the run that the i-th remaining node started (NULL if the list is
+// empty); the caller must free() it.  Returns the number of runs, which is
+// the new count of the list.
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error and return -1.
+//   - For group(): malloc() fails.  Print error and return -1; the list is
+//     not changed.
+
+/* Collapses each run of equal strings into its first node, and stores the
+ * size of each run in counts[] (if it is not NULL).  Returns the number of
+ * runs.
+ */
+static int encList_Str__collapse(EncList_Str *obj, int *counts)
+{
+	EncNode_Str *keep, *node, *next;
+	int groups = 0, run;
+
+	for (keep = obj->head; keep; keep = keep->next) {
+		run = 1;
+		for (node = keep->next; node && encNode_Str__cmp(keep, node) == 0; node = next) {
+			next = node->next;
+			encNode_Str__free(node);
+			run++;
+		}
+		ENCLIST_STR_STAT(nodesWalked, run);
+
+		keep->next = node;
+		if (node)
+			node->prev = keep;
+		else
+			obj->tail = keep;
+
+		if (counts)
+			counts[groups] = run;
+		groups++;
+	}
+
+	obj->count = groups;
+	encList_Str__indexDirty(obj);
+	return groups;
+}
+
+int encList_Str__unique(EncList_Str *obj)
+{
+	int before;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__unique: The object is NULL.\n");
+		return -1;
+	}
+	ENCLIST_STR_BEGIN();
+
+	before = obj->count;
+	encList_Str__collapse(obj, NULL);
+
+	ENCLIST_STR_END("unique");
+	return before - obj->count;
+}
+int encList_Str__group(EncList_Str *obj, int **counts)
+{
+	int *runs = NULL, *shrunk;
+	int before, groups;
+
+	if (!obj || !counts) {
+		fprintf(stderr, "encList_Str__group: The object or counts is NULL.\n");
+		return -1;
+	}
+
+	/* Room for the worst case (no duplicates at all), before anything is
+	 * freed; the extra is given back at the end
+	 */
+	before = obj->count;
+	if (before) {
+		runs = (int *)malloc(sizeof(int) * before);
+		if (!runs) {
+			perror("malloc");
+			return -1;
+		}
+		ENCLIST_STR_STAT(mallocs, 1);
+	}
+	ENCLIST_STR_BEGIN();
+
+	groups = encList_Str__collapse(obj, runs);
+	if (groups && groups < before) {
+		shrunk = (int *)realloc(runs, sizeof(int) * groups);
+		if (shrunk)
+			runs = shrunk;
+	}
+
+	ENCLIST_STR_END("group");
+	*counts = runs;
+	return groups;
+}
+
+// ---------------- mergeUnique ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             another list
+//
+// Equivalent to merge() followed by unique(), but in a single pass: a node
+// whose string is equal to the last one already placed in the merged list
+// is freed on the spot, instead of being linked in.  So, with sorted lists,
+// the result in lhs holds one node for each string found in either list
+// (the first one: from lhs, if both had it), and rhs is left empty.  Neither
+// list needs to be free of duplicates to begin with.
+//
+// ERRORS:
+//   Either pointer is NULL.  Print error.
+
+void encList_Str__mergeUnique(EncList_Str *lhs, EncList_Str *rhs)
+{
+	EncList_Str obj = { NULL, NULL, 0, NULL, NULL, NULL };
+	EncNode_Str *left, *right, *node;
+
+	if (!lhs || !rhs) {
+		fprintf(stderr, "encList_Str__mergeUnique: The object is NULL.\n");
+		return;
+	}
+	ENCLIST_STR_BEGIN();
+
+	left = lhs->head;
+	right = rhs->head;
+	while (left || right) {
+		/* Take the minimum node; ties go to lhs, so its node is kept */
+		if (!right || (left && encNode_Str__cmp(left, right) <= 0)) {
+			node = left;
+			left = left->next;
+		} else {
+			node = right;
+			right = right->next;
+		}
+
+		/* The merged list is sorted, so any copy is of its tail */
+		if (obj.tail && encNode_Str__cmp(obj.tail, node) == 0) {
+			encNode_Str__free(node);
+			continue;
+		}
+
+		node->prev = obj.tail;
+		if (obj.tail)
+			obj.tail->next = node;
+		else
+			obj.head = node;
+		obj.tail = node;
+		obj.count++;
+	}
+	if (obj.tail)
+		obj.tail->next = NULL;
+
+	/* Assign the merged list to lhs, and empty rhs */
+	lhs->head = obj.head;
+	lhs->tail = obj.tail;
+	lhs->count = obj.count;
+	rhs->head = NULL;
+	rhs->tail = NULL;
+	rhs->count = 0;
+	encList_Str__indexDirty(lhs);
+	encList_Str__indexClear(rhs);
+	ENCLIST_STR_END("mergeUnique");
+}
+
+// ---------------- sort ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Sorts the list in place, using a bottom-up merge sort built on merge().
+// Nodes are taken off the head one at a time and carried through an array of
+// pending runs, where slot i holds a sorted run of exactly 2^i nodes (much
+// like incrementing a binary counter).  Whenever two runs of the same size
+// meet, they are merged into one run of twice the size.  At the end, the
+// leftover runs are merged together, smallest first.
+//
+// There is no recursion, and no memory is allocated: the pending runs live
+// in a small fixed array on the stack (one slot per bit of an int), so the
+// stack does not grow with the size of the list.  The sort is stable: an
+// older run is always passed to merge() as the left-hand side, and merge()
+// prefers the left-hand side on ties.
+//
+// NOTE: Just like merge(), strings are *NOT* copied; only the next/prev
+//       arrows are changed.
+//
+// ERRORS:
+//   'this' is NULL.  Print error.
+
+void encList_Str__sort(EncList_Str *obj)
+{
+	EncList_Str runs[sizeof(int) * 8];
+	EncList_Str carry;
+	EncNode_Str *node;
+	int i, used = 0;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__sort: The object is NULL.\n");
+		return;
+	}
+
+	/* Nothing to do */
+	if (obj->count < 2)
+		return;
+	ENCLIST_STR_BEGIN();
+
+	while (obj->head) {
+		/* Take the head off as a run of length 1 */
+		node = obj->head;
+		obj->head = node->next;
+		node->next = NULL;
+		node->prev = NULL;
+
+		carry.head = node;
+		carry.tail = node;
+		carry.count = 1;
+		carry.pool = obj->pool;
+		carry.intern = obj->intern;
+		carry.index = NULL;
+
+		/* Merge with pending runs of the same size */
+		for (i = 0; i < used && runs[i].head; i++) {
+			encList_Str__merge(&runs[i], &carry);
+			carry = runs[i];
+			runs[i].head = NULL;
+		}
+		runs[i] = carry;
+		if (i == used)
+			used++;
+	}
+
+	/* Merge the leftover runs; larger slots hold earlier nodes */
+	carry.head = NULL;
+	carry.tail = NULL;
+	carry.count = 0;
+	carry.pool = obj->pool;
+	carry.intern = obj->intern;
+	carry.index = NULL;
+	for (i = 0; i < used; i++) {
+		if (!runs[i].head)
+			continue;
+		encList_Str__merge(&runs[i], &carry);
+		carry = runs[i];
+	}
+
+	obj->head = carry.head;
+	obj->tail = carry.tail;
+	obj->count = carry.count;
+	encList_Str__indexDirty(obj);
+	ENCLIST_STR_END("sort");
+}
+
+// ---------------- sortNatural ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Sorts the list in place, like sort(), but takes advantage of any order
+// that is already present in the input.  The list is cut into "natural"
+// runs: each run is either ascending (every node <= the next) or strictly
+// descending (every node > the next).  Descending runs are reversed by
+// relinking their nodes; since they are *strictly* descending, this never
+// reorders equal strings.
+//
+// Runs are pushed onto a small stack, and merged using the same rules as
+// TimSort, so that the merges stay balanced:
+//     len[n-3] >  len[n-2] + len[n-1]
+//     len[n-2] >  len[n-1]
+// The merges use a "galloping" policy (see mergeGallop() below): once one
+// side has won several comparisons in a row, the merge switches to an
+// exponential search, and moves whole blocks of nodes at once.
+//
+// Runs shorter than ENCLIST_STR_MIN_RUN are padded out with the nodes that
+// follow them, and sorted with sort(), before they are pushed.
+//
+// An input which is already sorted (or sorted in reverse) is a single run,
+// and costs N-1 comparisons.  Random input costs about the same as sort().
+//
+// ERRORS:
+//   'this' is NULL.  Print error.
+
+#define ENCLIST_STR_MIN_GALLOP	7
+#define ENCLIST_STR_MIN_RUN	32
+
+/* Returns the node 'steps' positions after 'node', or the last node of the
+ * chain if the chain is shorter than that.  '*taken' is set to the number of
+ * steps actually taken.
+ */
+static EncNode_Str *encNode_Str__advance(EncNode_Str *node, int steps, int *taken)
+{
+	int i;
+
+	for (i = 0; i < steps && node->next; i++)
+		node = node->next;
+
+	*taken = i;
+	return node;
+}
+
+/* Starting at 'node' (which is known to belong in the block), finds the last
+ * node of the chain which still belongs before 'key'.  If 'strict' is set, a
+ * node belongs in the block only if it is less than 'key'; otherwise it
+ * belongs if it is less than or equal to 'key'.
+ *
+ * The search gallops: it probes 1, 2, 4, ... nodes ahead, and then does a
+ * binary search inside the last step.  Nodes are still walked one at a time,
+ * but only O(log k) of them are compared, for a block of k nodes.
+ */
+static EncNode_Str *encNode_Str__gallop(EncNode_Str *node, EncNode_Str *key, int strict)
+{
+	EncNode_Str *probe;
+	int step = 1, taken, cmp;
+
+	/* Exponential search: 'node' is in the block, 'probe' is the candidate */
+	while (node->next) {
+		probe = encNode_Str__advance(node, step, &taken);
+		cmp = encNode_Str__cmp(probe, key);
+		if (strict ? cmp >= 0 : cmp > 0)
+			break;
+		node = probe;
+		step *= 2;
+	}
+	if (!node->next)
+		return node;
+
+	/* Binary search: the answer is 'node', or one of the 'taken'-1 nodes
+	 * strictly between 'node' and 'probe'
+	 */
+	step = taken - 1;
+	while (step > 0) {
+		int half = (step + 1) / 2;
+
+		probe = encNode_Str__advance(node, half, &taken);
+		cmp = encNode_Str__cmp(probe, key);
+		if (strict ? cmp < 0 : cmp <= 0) {
+			node = probe;
+			step -= half;
+		} else
+			step = half - 1;
+	}
+
+	return node;
+}
+
+/* Merges two sorted lists, just like merge() (the result is in 'lhs', and
+ * ties go to 'lhs'), but uses a galloping policy.
+ *
+ * Rather than moving one node at a time, this walks along one side for as
+ * long as its nodes come before the head of the other side, and only then
+ * relinks - so a block of nodes that stays together costs a single pair of
+ * pointer updates.  Once a block reaches ENCLIST_STR_MIN_GALLOP nodes, the
+ * rest of it is found with an exponential search (see gallop() above).  If
+ * the lists do not overlap at all, one is simply appended to the other.
+ */
+static void encList_Str__mergeGallop(EncList_Str *lhs, EncList_Str *rhs)
+{
+	EncNode_Str *a, *b, *next, *head;
+	int strict, steps, cmp;
+
+	if (!rhs->head)
+		return;
+	if (!lhs->head || encNode_Str__cmp(lhs->tail, rhs->head) <= 0) {
+		encList_Str__append(lhs, rhs);
+		return;
+	}
+	if (encNode_Str__cmp(rhs->tail, lhs->head) < 0) {
+		encList_Str__append(rhs, lhs);
+		*lhs = *rhs;
+		rhs->head = NULL;
+		rhs->tail = NULL;
+		rhs->count = 0;
+		return;
+	}
+
+	/* 'a' is the side that holds the next node of the merged list, and 'b'
+	 * is the other side.  'strict' is set when 'a' is the rhs, since rhs
+	 * nodes must be strictly less than lhs nodes to go first.
+	 */
+	if (encNode_Str__cmp(lhs->head, rhs->head) <= 0) {
+		a = lhs->head;
+		b = rhs->head;
+		strict = 0;
+	} else {
+		a = rhs->head;
+		b = lhs->head;
+		strict = 1;
+	}
+	head = a;
+
+	for (;;) {
+		/* Find the last node of the block which comes before 'b' */
+		steps = 0;
+		while (a->next) {
+			if (steps >= ENCLIST_STR_MIN_GALLOP) {
+				a = encNode_Str__gallop(a, b, strict);
+				break;
+			}
+			cmp = encNode_Str__cmp(a->next, b);
+			if (strict ? cmp >= 0 : cmp > 0)
+				break;
+			a = a->next;
+			steps++;
+		}
+
+		/* Link the other side in after the block */
+		next = a->next;
+		a->next = b;
+		b->prev = a;
+
+		/* This side ran out; the rest of the other side is already
+		 * chained together
+		 */
+		if (!next)
+			break;
+
+		a = b;
+		b = next;
+		strict = !strict;
+	}
+
+	lhs->head = head;
+	lhs->tail = strict ? lhs->tail : rhs->tail;
+	lhs->count += rhs->count;
+	rhs->head = NULL;
+	rhs->tail = NULL;
+	rhs->count = 0;
+}
+
+/* Merges runs[i] and runs[i+1] of the pending-run stack, and closes the gap */
+static void encList_Str__mergeRunsAt(EncList_Str *runs, int *used, int i)
+{
+	encList_Str__mergeGallop(&runs[i], &runs[i + 1]);
+	if (i + 2 < *used)
+		runs[i + 1] = runs[i + 2];
+	(*used)--;
+}
+
+void encList_Str__sortNatural(EncList_Str *obj)
+{
+	EncList_Str runs[sizeof(int) * 16];
+	EncNode_Str *first, *last, *node, *next;
+	int used = 0, len, i;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__sortNatural: The object is NULL.\n");
+		return;
+	}
+
+	/* Nothing to do */
+	if (obj->count < 2)
+		return;
+	ENCLIST_STR_BEGIN();
+
+	while (obj->head) {
+		/* Find the end of the next run */
+		first = obj->head;
+		last = first;
+		len = 1;
+		if (last->next && encNode_Str__cmp(last->next, last) < 0) {
+			while (last->next && encNode_Str__cmp(last->next, last) < 0) {
+				last = last->next;
+				len++;
+			}
+		} else {
+			while (last->next && encNode_Str__cmp(last, last->next) <= 0) {
+				last = last->next;
+				len++;
+			}
+		}
+
+		/* Cut the run off of the list */
+		obj->head = last->next;
+		if (obj->head)
+			obj->head->prev = NULL;
+		first->prev = NULL;
+		last->next = NULL;
+
+		/* Reverse a descending run by swapping the arrows of every node */
+		if (first != last && encNode_Str__cmp(first, last) > 0) {
+			for (node = first; node; node = next) {
+				next = node->next;
+				node->next = node->prev;
+				node->prev = next;
+			}
+			node = first;
+			first = last;
+			last = node;
+		}
+
+		runs[used].head = first;
+		runs[used].tail = last;
+		runs[used].count = len;
+		runs[used].pool = obj->pool;
+		runs[used].intern = obj->intern;
+		runs[used].index = NULL;
+
+		/* Short runs are extended with the nodes that follow them, and
+		 * sorted with sort(), so that random input does not turn into
+		 * a huge number of tiny merges
+		 */
+		if (len < ENCLIST_STR_MIN_RUN && obj->head) {
+			first = obj->head;
+			last = encNode_Str__advance(first, ENCLIST_STR_MIN_RUN - len - 1, &i);
+			obj->head = last->next;
+			if (obj->head)
+				obj->head->prev = NULL;
+			last->next = NULL;
+
+			first->prev = runs[used].tail;
+			runs[used].tail->next = first;
+			runs[used].tail = last;
+			runs[used].count += i + 1;
+			encList_Str__sort(&runs[used]);
+		}
+		used++;
+
+		/* Restore the stack invariants (the corrected TimSort rules) */
+		while (used > 1) {
+			i = used - 2;
+			if ((i > 0 && runs[i - 1].count <= runs[i].count + runs[i + 1].count) ||
+			    (i > 1 && runs[i - 2].count <= runs[i - 1].count + runs[i].count)) {
+				if (runs[i - 1].count < runs[i + 1].count)
+					i--;
+			} else if (runs[i].count > runs[i + 1].count)
+				break;
+			encList_Str__mergeRunsAt(runs, &used, i);
+		}
+	}
+
+	/* Merge whatever is left, newest runs first */
+	while (used > 1)
+		encList_Str__mergeRunsAt(runs, &used, used - 2);
+
+	obj->head = runs[0].head;
+	obj->tail = runs[0].tail;
+	obj->count = runs[0].count;
+	encList_Str__indexDirty(obj);
+	ENCLIST_STR_END("sortNatural");
+}
+
+// ---------------- sortParallel ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             number of threads to use
+//
+// Sorts the list in place, using up to 'nthreads' threads (the calling thread
+// is one of them).  The result is exactly the same as sort() - the sort is
+// stable, and only the next/prev arrows are changed.
+//
+// The work is done in three steps:
+//   1. One pass over the list cuts it into ENCLIST_STR_PAR_SPLIT chunks per
+//      thread, and picks a sample of nodes along the way.  The sample is
+//      sorted, and evenly spaced sample nodes become "splitters," which
+//      divide the key space into ranges.
+//   2. Each chunk is sorted with sort(), and then cut into one slice per
+//      range: slice j holds the nodes of the chunk which are greater than
+//      splitter j-1, and no greater than splitter j.
+//   3. Each range is built by merging slice j of every chunk with mergeK(),
+//      in chunk order (so that ties keep their order).  The ranges are
+//      disjoint, so they are simply appended to each other at the end.
+//
+// Steps 2 and 3 are broken up into one task per chunk (or range), and handed
+// out to a small work-stealing pool: every thread has its own queue of
+// tasks, and a thread whose queue is empty steals from the others.
+//
+// Short lists (or nthreads <= 1) are simply passed to sort().  If threads
+// cannot be created, the calling thread does the work itself.
+//
+// ERRORS:
+//   - 'this' is NULL.  Print error.
+//   - malloc() fails.  Print error, and fall back to sort().
+
+#define ENCLIST_STR_PAR_SPLIT		4	/* chunks (and ranges) per thread */
+#define ENCLIST_STR_PAR_SAMPLE		16	/* sample nodes per range */
+#define ENCLIST_STR_PAR_MIN_CHUNK	4096	/* below this, don't bother */
+
+typedef struct EncList_Str_ParSort EncList_Str_ParSort;
+typedef struct EncList_Str_ParWorker EncList_Str_ParWorker;
+
+struct EncList_Str_ParWorker {
+	EncList_Str_ParSort	*ps;
+	pthread_t		thread;
+	int			started;
+	pthread_mutex_t		lock;
+	int			*tasks;
+	int			top;		/* next task to steal */
+	int			bottom;		/* one past the next own task */
+#ifdef LIST_STATS
+	ListStats		stats;		/* the thread's counts, when it is done */
+#endif
+};
+
+struct EncList_Str_ParSort {
+	EncList_Str_ParWorker	*workers;
+	int			nworkers;
+	void			(*run)(EncList_Str_ParSort *ps, int task);
+
+	EncList_Str		*chunks;
+	int			nchunks;
+	EncNode_Str		**splitters;	/* nranges-1 of them */
+	int			nranges;
+	EncList_Str		*slices;	/* [chunk * nranges + range] */
+	EncList_Str		**merging;	/* [range * nchunks + chunk] */
+};
+
+/* Takes a task from the worker's own queue (newest first), or steals one
+ * from another worker (oldest first).  Returns -1 when every queue is empty.
+ */
+static int encList_Str__parTake(EncList_Str_ParWorker *self)
+{
+	EncList_Str_ParSort *ps = self->ps;
+	EncList_Str_ParWorker *victim;
+	int i, task = -1;
+
+	pthread_mutex_lock(&self->lock);
+	if (self->bottom > self->top)
+		task = self->tasks[--self->bottom];
+	pthread_mutex_unlock(&self->lock);
+
+	for (i = 1; task < 0 && i < ps->nworkers; i++) {
+		victim = &ps->workers[(self - ps->workers + i) % ps->nworkers];
+
+		pthread_mutex_lock(&victim->lock);
+		if (victim->bottom > victim->top)
+			task = victim->tasks[victim->top++];
+		pthread_mutex_unlock(&victim->lock);
+	}
+
+	return task;
+}
+
+/* Runs tasks until there are none left in any queue */
+static void *encList_Str__parDrain(void *arg)
+{
+	EncList_Str_ParWorker *self = (EncList_Str_ParWorker *)arg;
+	int task;
+
+#ifdef LIST_STATS
+	/* The tasks are part of sortParallel(); don't trace them on their own */
+	encList_Str__depth++;
+#endif
+	while ((task = encList_Str__parTake(self)) >= 0)
+		self->ps->run(self->ps, task);
+#ifdef LIST_STATS
+	encList_Str__depth--;
+	self->stats = encList_Str__stats;
+#endif
+
+	return NULL;
+}
+
+/* Deals 'ntasks' tasks out to the workers, and runs them all; returns once
+ * every task has finished
+ */
+static void encList_Str__parRun(EncList_Str_ParSort *ps, int ntasks,
+                                void (*run)(EncList_Str_ParSort *, int))
+{
+	int i, err;
+
+	ps->run = run;
+	for (i = 0; i < ps->nworkers; i++) {
+		ps->workers[i].top = 0;
+		ps->workers[i].bottom = 0;
+	}
+	for (i = 0; i < ntasks; i++) {
+		EncList_Str_ParWorker *worker = &ps->workers[i % ps->nworkers];
+
+		worker->tasks[worker->bottom++] = i;
+	}
+
+	/* Worker 0 is the calling thread */
+	for (i = 1; i < ps->nworkers; i++) {
+		err = pthread_create(&ps->workers[i].thread, NULL,
+		                     encList_Str__parDrain, &ps->workers[i]);
+		/* If this fails, the others will steal this worker's tasks */
+		if (err)
+			fprintf(stderr, "pthread_create: %s\n", strerror(err));
+		ps->workers[i].started = !err;
+	}
+	encList_Str__parDrain(&ps->workers[0]);
+	for (i = 1; i < ps->nworkers; i++) {
+		if (ps->workers[i].started) {
+			pthread_join(ps->workers[i].thread, NULL);
+#ifdef LIST_STATS
+			listStats__add(&encList_Str__stats, &ps->workers[i].stats);
+#endif
+		}
+	}
+}
+
+/* Step 2: sorts one chunk, and cuts it into slices at the splitters */
+static void encList_Str__parSortChunk(EncList_Str_ParSort *ps, int task)
+{
+	EncList_Str *chunk = &ps->chunks[task];
+	EncList_Str *slices = &ps->slices[task * ps->nranges];
+	EncNode_Str *pos, *first;
+	int range, count;
+
+	encList_Str__sort(chunk);
+
+	pos = chunk->head;
+	for (range = 0; range < ps->nranges - 1; range++) {
+		first = pos;
+		count = 0;
+		while (pos && encNode_Str__cmp(pos, ps->splitters[range]) <= 0) {
+			pos = pos->next;
+			count++;
+		}
+
+		slices[range].pool = chunk->pool;
+		slices[range].intern = chunk->intern;
+		if (!count) {
+			slices[range].head = NULL;
+			slices[range].tail = NULL;
+			slices[range].count = 0;
+			continue;
+		}
+
+		/* Cut [first, pos) off of the front of the chunk */
+		slices[range].head = first;
+		slices[range].tail = pos ? pos->prev : chunk->tail;
+		slices[range].count = count;
+		slices[range].tail->next = NULL;
+		if (pos)
+			pos->prev = NULL;
+		chunk->count -= count;
+	}
+
+	/* The last slice gets everything that is left */
+	slices[range].pool = chunk->pool;
+	slices[range].intern = chunk->intern;
+	slices[range].head = pos;
+	slices[range].tail = pos ? chunk->tail : NULL;
+	slices[range].count = chunk->count;
+}
+
+/* Step 3: merges slice 'task' of every chunk, in chunk order */
+static void encList_Str__parMergeRange(EncList_Str_ParSort *ps, int task)
+{
+	EncList_Str **lists = &ps->merging[task * ps->nchunks];
+	int i;
+
+	for (i = 0; i < ps->nchunks; i++)
+		lists[i] = &ps->slices[i * ps->nranges + task];
+	encList_Str__mergeK(lists, ps->nchunks);
+}
+
+/* qsort() comparator for the sample */
+static int encList_Str__parCmpSample(const void *a, const void *b)
+{
+	return encNode_Str__cmp(*(EncNode_Str **)a, *(EncNode_Str **)b);
+}
+
+void encList_Str__sortParallel(EncList_Str *obj, int nthreads)
+{
+	EncList_Str_ParSort ps;
+	EncNode_Str **sample = NULL, *pos;
+	int nsample, chunkLen, i, j;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__sortParallel: The object is NULL.\n");
+		return;
+	}
+	ENCLIST_STR_BEGIN();
+
+	if (nthreads > obj->count / ENCLIST_STR_PAR_MIN_CHUNK)
+		nthreads = obj->count / ENCLIST_STR_PAR_MIN_CHUNK;
+	if (nthreads <= 1) {
+		encList_Str__sort(obj);
+		ENCLIST_STR_END("sortParallel");
+		return;
+	}
+
+	memset(&ps, 0, sizeof(ps));
+	ps.nworkers = nthreads;
+	ps.nchunks = nthreads * ENCLIST_STR_PAR_SPLIT;
+	ps.nranges = nthreads * ENCLIST_STR_PAR_SPLIT;
+	nsample = ps.nranges * ENCLIST_STR_PAR_SAMPLE;
+
+	ps.workers = (EncList_Str_ParWorker *)calloc(ps.nworkers, sizeof(EncList_Str_ParWorker));
+	ps.chunks = (EncList_Str *)calloc(ps.nchunks, sizeof(EncList_Str));
+	ps.slices = (EncList_Str *)calloc(ps.nchunks * ps.nranges, sizeof(EncList_Str));
+	ps.splitters = (EncNode_Str **)calloc(ps.nranges, sizeof(EncNode_Str *));
+	ps.merging = (EncList_Str **)calloc(ps.nranges * ps.nchunks, sizeof(EncList_Str *));
+	sample = (EncNode_Str **)calloc(nsample, sizeof(EncNode_Str *));
+	if (ps.workers)
+		ps.workers[0].tasks = (int *)calloc(ps.nworkers * ps.nchunks, sizeof(int));
+	if (!ps.workers || !ps.chunks || !ps.slices || !ps.splitters ||
+	    !ps.merging || !sample || !ps.workers[0].tasks) {
+		perror("calloc");
+		if (ps.workers)
+			free(ps.workers[0].tasks);
+		free(ps.workers);
+		free(ps.chunks);
+		free(ps.slices);
+		free(ps.splitters);
+		free(ps.merging);
+		free(sample);
+		encList_Str__sort(obj);
+		ENCLIST_STR_END("sortParallel");
+		return;
+	}
+	ENCLIST_STR_STAT(mallocs, 7);
+	for (i = 0; i < ps.nworkers; i++) {
+		ps.workers[i].ps = &ps;
+		ps.workers[i].tasks = ps.workers[0].tasks + i * ps.nchunks;
+		pthread_mutex_init(&ps.workers[i].lock, NULL);
+	}
+
+	/* Step 1: cut the list into chunks, and take the sample, in one pass */
+	chunkLen = obj->count / ps.nchunks;
+	pos = obj->head;
+	j = 0;
+	for (i = 0; i < ps.nchunks; i++) {
+		EncList_Str *chunk = &ps.chunks[i];
+		int len = i < ps.nchunks - 1 ? chunkLen : obj->count - chunkLen * i;
+		int k;
+
+		chunk->pool = obj->pool;
+		chunk->intern = obj->intern;
+		chunk->head = pos;
+		chunk->count = len;
+		pos->prev = NULL;
+		for (k = 1; k < len; k++) {
+			pos = pos->next;
+			if (k % (chunkLen / ENCLIST_STR_PAR_SAMPLE) == 0 && j < nsample)
+				sample[j++] = pos;
+		}
+		chunk->tail = pos;
+		pos = pos->next;
+		chunk->tail->next = NULL;
+	}
+	nsample = j;
+
+	qsort(sample, nsample, sizeof(EncNode_Str *), encList_Str__parCmpSample);
+	for (i = 0; i < ps.nranges - 1; i++)
+		ps.splitters[i] = sample[(i + 1) * nsample / ps.nranges];
+
+	/* Steps 2 and 3 */
+	encList_Str__parRun(&ps, ps.nchunks, encList_Str__parSortChunk);
+	encList_Str__parRun(&ps, ps.nranges, encList_Str__parMergeRange);
+
+	/* The merged ranges are in slices[0][range]; put them back together */
+	obj->head = NULL;
+	obj->tail = NULL;
+	obj->count = 0;
+	for (i = 0; i < ps.nranges; i++)
+		encList_Str__append(obj, &ps.slices[i]);
+	encList_Str__indexDirty(obj);
+
+	for (i = 0; i < ps.nworkers; i++)
+		pthread_mutex_destroy(&ps.workers[i].lock);
+	free(ps.workers[0].tasks);
+	free(ps.workers);
+	free(ps.chunks);
+	free(ps.slices);
+	free(ps.splitters);
+	free(ps.merging);
+	free(sample);
+	ENCLIST_STR_STAT(frees, 7);
+	ENCLIST_STR_END("sortParallel");
+}
+
+// ---------------- sortRadix ----------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//
+// Sorts the list in place, like sort(), but with a most-significant-digit
+// radix sort, which never compares two strings: each pass looks at one byte
+// of each string, and relinks the nodes into 257 buckets (one for strings
+// which have no byte at that depth, which sort first, and one per byte
+// value).  Each bucket is then sorted the same way, one byte deeper.
+// Buckets with fewer than ENCLIST_STR_RADIX_MIN nodes are sorted with sort()
+// instead (and so with merge()), since a pass over 257 buckets is not worth
+// it for a handful of nodes.
+//
+// For long, random keys, this looks at each byte of a key at most once
+// (and only as many bytes as it takes to tell the key apart), instead of
+// comparing whole strings O(log N) times each.  The first 8 bytes come from
+// the cached key prefix, so they don't touch the string at all.  On the
+// other hand, keys which share long prefixes cost a pass per shared byte.
+//
+// The sort is stable: nodes go into each bucket in list order, the bucket
+// of strings which have ended holds equal strings only, and sort() is
+// stable.  There is no recursion: the buckets that still need sorting are
+// kept as segments of the list, on a stack which is malloc()ed.
+//
+// ERRORS:
+//   - 'this' is NULL.  Print error.
+//   - malloc() fails.  Print error, and fall back to sort().
+
+#define ENCLIST_STR_RADIX_MIN	64
+
+typedef struct EncList_Str_RadixSeg EncList_Str_RadixSeg;
+struct EncList_Str_RadixSeg {
+	EncNode_Str	*first;
+	EncNode_Str	*last;
+	int		count;
+	unsigned int	depth;
+};
+
+/* Returns the bucket of the node, at the given depth: 0 if the string is
+ * shorter than that, else the byte at that depth, plus 1
+ */
+static inline int encNode_Str__digit(EncNode_Str *node, unsigned int depth)
+{
+	if (depth >= node->len)
+		return 0;
+	if (depth < ENCNODE_STR_PREFIX)
+		return ((node->key >> (8 * (ENCNODE_STR_PREFIX - 1 - depth))) & 0xff) + 1;
+	return (unsigned char)node->str[depth] + 1;
+}
+
+/* Replaces a segment of obj's chain with the chain first..last (which holds
+ * the same nodes, in a new order).  'before' and 'after' are the neighbors
+ * of the segment (NULL at the ends of the list).
+ */
+static void encList_Str__radixSplice(EncList_Str *obj, EncNode_Str *before, EncNode_Str *after,
+                                     EncNode_Str *first, EncNode_Str *last)
+{
+	first->prev = before;
+	if (before)
+		before->next = first;
+	else
+		obj->head = first;
+
+	last->next = after;
+	if (after)
+		after->prev = last;
+	else
+		obj->tail = last;
+}
+
+/* Sorts one segment with sort() */
+static void encList_Str__radixSmall(EncList_Str *obj, EncList_Str_RadixSeg *seg)
+{
+	EncNode_Str *before = seg->first->prev, *after = seg->last->next;
+	EncList_Str part;
+
+	seg->first->prev = NULL;
+	seg->last->next = NULL;
+	part.head = seg->first;
+	part.tail = seg->last;
+	part.count = seg->count;
+	part.pool = obj->pool;
+	part.intern = obj->intern;
+	part.index = NULL;
+
+	encList_Str__sort(&part);
+	encList_Str__radixSplice(obj, before, after, part.head, part.tail);
+}
+
+void encList_Str__sortRadix(EncList_Str *obj)
+{
+	EncNode_Str *heads[257], *tails[257];
+	int counts[257];
+	EncList_Str_RadixSeg *stack, seg;
+	int top, cap, i;
+
+	if (!obj) {
+		fprintf(stderr, "encList_Str__sortRadix: The object is NULL.\n");
+		return;
+	}
+
+	/* Nothing to do */
+	if (obj->count < 2)
+		return;
+	ENCLIST_STR_BEGIN();
+
+	cap = 64;
+	stack = (EncList_Str_RadixSeg *)malloc(sizeof(EncList_Str_RadixSeg) * cap);
+	if (!stack) {
+		perror("malloc");
+		encList_Str__sort(obj);
+		ENCLIST_STR_END("sortRadix");
+		return;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	stack[0].first = obj->head;
+	stack[0].last = obj->tail;
+	stack[0].count = obj->count;
+	stack[0].depth = 0;
+	top = 1;
+
+	while (top) {
+		EncNode_Str *before, *after, *node, *next, *first = NULL, *last = NULL;
+		unsigned int depth;
+
+		seg = stack[--top];
+		if (seg.count < ENCLIST_STR_RADIX_MIN) {
+			encList_Str__radixSmall(obj, &seg);
+			continue;
+		}
+
+		/* Deal the nodes out into buckets, in order */
+		before = seg.first->prev;
+		after = seg.last->next;
+		memset(counts, 0, sizeof(counts));
+		for (node = seg.first, i = 0; i < seg.count; node = next, i++) {
+			int d = encNode_Str__digit(node, seg.depth);
+
+			next = node->next;
+			if (!counts[d]++) {
+				heads[d] = node;
+				node->prev = NULL;
+			} else {
+				tails[d]->next = node;
+				node->prev = tails[d];
+			}
+			tails[d] = node;
+		}
 
-		head->prev = NULL;
-		head->next = NULL;
+		/* Chain the buckets back together, in place of the segment, and
+		 * push the ones which need more sorting.  (Bucket 0 never does:
+		 * its strings are all equal.)
+		 */
+		for (i = 0; i < 257; i++) {
+			if (!counts[i])
+				continue;
+			if (last) {
+				last->next = heads[i];
+				heads[i]->prev = last;
+			} else
+				first = heads[i];
+			last = tails[i];
+		}
+		encList_Str__radixSplice(obj, before, after, first, last);
+
+		depth = seg.depth + 1;
+		for (i = 256; i > 0; i--) {
+			if (counts[i] < 2)
+				continue;
+
+			seg.first = heads[i];
+			seg.last = tails[i];
+			seg.count = counts[i];
+			seg.depth = depth;
+			if (top == cap) {
+				EncList_Str_RadixSeg *grown;
+
+				grown = (EncList_Str_RadixSeg *)realloc(stack, sizeof(EncList_Str_RadixSeg) * cap * 2);
+				if (!grown) {
+					/* Sort this bucket right away instead */
+					perror("realloc");
+					encList_Str__radixSmall(obj, &seg);
+					continue;
+				}
+				stack = grown;
+				cap *= 2;
+				ENCLIST_STR_STAT(mallocs, 1);
+				ENCLIST_STR_STAT(frees, 1);
+			}
+			stack[top++] = seg;
+		}
 	}
 
-	return head;
+	free(stack);
+	ENCLIST_STR_STAT(frees, 1);
+	encList_Str__indexDirty(obj);
+	ENCLIST_STR_END("sortRadix");
 }
 
-// ------------- alloc() - Constructor ---------------
-// Parameters: None
+// ------------- EncKey_Str (sort keys) ---------------
 //
-// Allocates a new EncList_Str object, and initializes it to hold an empty
-// list (that is, no node objects should be allocated).
+// By default, the lists compare strings byte by byte (as strcmp() does).
+// A sort key gives the ...By() methods - sortBy(), mergeBy(), getMinBy() and
+// getMaxBy() - a different order: each string is turned into a binary key,
+// once, before the method starts, and then the keys are compared byte by
+// byte instead (with memcmp(), and with the same cached prefixes as plain
+// strings).  The available keys are:
+//
+//   allocNumeric(): the integer at the start of the string (after any
+//                   blanks, with an optional sign), like "sort -n".  A string
+//                   that does not start with a number counts as 0.
+//   allocFold():    the string, with ASCII letters folded to lower case.
+//   allocField():   field number 'field' (counting from 1) of the string,
+//                   as split by the 'sep' character, like "sort -t -k";
+//                   it is compared as it is, or by the key 'then' if that is
+//                   not NULL.  A missing field is an empty key.
+//   allocCustom():  whatever 'fn' makes of the string.  fn(str, len, key,
+//                   cap, arg) must store the key for the 'len' bytes at
+//                   'str' into key[0..cap), and return its length; if that
+//                   is more than cap, it is called again with enough room.
+//                   It can return a negative number to report an error,
+//                   which makes the method fail (see below).
+//
+// free(): Frees the key - along with its 'then' key, for a field key.
+//
+// A key can be used by any number of methods, and lists, at the same time.
 //
 // ERRORS:
-//   - malloc() fails.  Print error and return NULL
+//   - malloc() fails.  Print error and return NULL.
+//   - For allocField(): field < 1.  Print error and return NULL.
+//   - For allocCustom()/free(): pointer is NULL.  Print error (and return
+//     NULL).
 
-EncList_Str *encList_Str__alloc()
+static EncKey_Str *encKey_Str__allocKind(int kind)
 {
-	EncList_Str *obj;
+	EncKey_Str *key;
 
-	/* Allocate a new object */
-	obj = (EncList_Str *)malloc(sizeof(EncList_Str));
-	if (!obj) {
-	        perror("malloc");
-	        return NULL;
+	key = (EncKey_Str *)calloc(1, sizeof(EncKey_Str));
+	if (!key) {
+		perror("calloc");
+		return NULL;
 	}
+	ENCLIST_STR_STAT(mallocs, 1);
 
-	/* Initialize the object */
-	obj->head = NULL;
+	key->kind = kind;
+	return key;
+}
 
-	return obj;
+EncKey_Str *encKey_Str__allocNumeric()
+{
+	return encKey_Str__allocKind(ENCKEY_STR_NUMERIC);
+}
+EncKey_Str *encKey_Str__allocFold()
+{
+	return encKey_Str__allocKind(ENCKEY_STR_FOLD);
 }
+EncKey_Str *encKey_Str__allocField(char sep, int field, EncKey_Str *then)
+{
+	EncKey_Str *key;
 
-// -------------- free() - Destructor ----------------
-// Parameters: 'this' pointer (for the wrapper object)
-//
-// Frees an existing EncList_Str object.  If there are any nodes inside this
-// list, this also frees all of them.
-//
-// ERRORS:
-//   - Pointer is NULL
+	if (field < 1) {
+		fprintf(stderr, "encKey_Str__allocField: The field number is less than 1.\n");
+		return NULL;
+	}
 
-void encList_Str__free(EncList_Str *obj)
+	key = encKey_Str__allocKind(ENCKEY_STR_FIELD);
+	if (!key)
+		return NULL;
+	key->sep = sep;
+	key->field = field;
+	key->then = then;
+	return key;
+}
+EncKey_Str *encKey_Str__allocCustom(EncKey_Str_Fn fn, void *arg)
 {
-	EncNode_Str *pos, *next;
+	EncKey_Str *key;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__free: The object is NULL.\n");
-		return;
+	if (!fn) {
+		fprintf(stderr, "encKey_Str__allocCustom: The function is NULL.\n");
+		return NULL;
 	}
 
-	/* Free nodes */
-	pos = obj->head;
-	while (pos) {
-		next = pos->next;
-		encNode_Str__free(pos);
-		pos = next;
+	key = encKey_Str__allocKind(ENCKEY_STR_CUSTOM);
+	if (!key)
+		return NULL;
+	key->fn = fn;
+	key->arg = arg;
+	return key;
+}
+
+void encKey_Str__free(EncKey_Str *key)
+{
+	if (!key) {
+		fprintf(stderr, "encKey_Str__free: The key is NULL.\n");
+		return;
 	}
 
-	/* Free the object itself */
-	free(obj);
+	if (key->then)
+		encKey_Str__free(key->then);
+	free(key);
+	ENCLIST_STR_STAT(frees, 1);
 }
 
-// ---------------- addHead ---------------------------------
-// Parameters: 'this' pointer (for the wrapper object)
-//             *string*
-//             dup (boolean flag)
-//
-// Adds the given string to the front of the list (duplicates are allowed).  If
-// dup=1, then this method will malloc() a new buffer, and copy the string
-// into that buffer.  If dup=0, it will simply save the pointer into the node.
-//
-// When the node is destroyed later, free() will free the string if it was
-// duplicated in this function - but if it was not duplicated, then it will
-// *NOT* free it, and the caller is responsible for doing so.
-//
-// ERRORS:
-//   - Pointer is NULL.  Print error.
-
-void encList_Str__addHead(EncList_Str *obj, char *string, int dup)
+/* Stores the key for the 'len' bytes at 'str' into out[0..cap), and returns
+ * its length.  If that is more than cap, out[] may hold anything.
+ */
+static int encKey_Str__extract(EncKey_Str *key, const char *str, int len, char *out, int cap)
 {
-	EncNode_Str *node;
+	uint64_t val = 0, bits;
+	int i = 0, neg = 0, end, digit;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__addHead: The object is NULL.\n");
-		return;
-	}
+	switch (key->kind) {
+	case ENCKEY_STR_NUMERIC:
+		if (cap < 8)
+			return 8;
 
-	/* Allocate a new node */
-	node = encNode_Str__alloc(string, dup);
-	/* Errors should be handled in encNode_Str__alloc */
-	if (!node)
-		return;
+		while (i < len && (str[i] == ' ' || str[i] == '\t'))
+			i++;
+		if (i < len && (str[i] == '-' || str[i] == '+'))
+			neg = str[i++] == '-';
+		for (; i < len && str[i] >= '0' && str[i] <= '9'; i++) {
+			digit = str[i] - '0';
+			if (val > ((1ULL << 63) - digit) / 10) {	/* saturate */
+				val = 1ULL << 63;
+				break;
+			}
+			val = val * 10 + digit;
+		}
+		if (!neg && val == (1ULL << 63))
+			val--;
 
-	/* Add to the front of the list */
-	node->prev = NULL;
-	node->next = obj->head;
-	if (obj->head)
-		obj->head->prev = node;
-	obj->head = node;
-}
+		/* Offset by 2^63, so that unsigned order is numeric order, and
+		 * store big-endian, so that byte order is too
+		 */
+		bits = neg ? (1ULL << 63) - val : (1ULL << 63) + val;
+		for (i = 0; i < 8; i++)
+			out[i] = (char)(bits >> (56 - 8 * i));
+		return 8;
 
-// ---------------- addTail ---------------------------------
-// Parameters: 'this' pointer (for the wrapper object)
-//             *string*
-//             dup (boolean flag)
-//
-// Adds the given string to the end of the list (duplicates are allowed).  If
-// dup=1, then this method will malloc() a new buffer, and copy the string
-// into that buffer.  If dup=0, it will simply save the pointer into the node.
-//
-// When the node is destroyed later, free() will free the string if it was
-// duplicated in this function - but if it was not duplicated, then it will
-// *NOT* free it, and the caller is responsible for doing so.
-//
-// ERRORS:
-//   - Pointer is NULL.  Print error.
+	case ENCKEY_STR_FOLD:
+		if (cap < len)
+			return len;
+		for (i = 0; i < len; i++)
+			out[i] = str[i] >= 'A' && str[i] <= 'Z' ? str[i] - 'A' + 'a' : str[i];
+		return len;
 
-void encList_Str__addTail(EncList_Str *obj, char *string, int dup)
-{
-	EncNode_Str *node, *tail;
+	case ENCKEY_STR_FIELD:
+		for (neg = 1; neg < key->field && i < len; i++) {
+			if (str[i] == key->sep)
+				neg++;
+		}
+		if (neg < key->field)
+			i = len;	/* there is no such field */
+		for (end = i; end < len && str[end] != key->sep; end++)
+			;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__addTail: The object is NULL.\n");
-		return;
+		if (key->then)
+			return encKey_Str__extract(key->then, str + i, end - i, out, cap);
+		if (cap >= end - i && end > i)
+			memcpy(out, str + i, end - i);
+		return end - i;
+
+	default:
+		return key->fn(str, len, out, cap, key->arg);
 	}
+}
 
-	/* Allocate a new node */
-	node = encNode_Str__alloc(string, dup);
-	/* Errors should be handled in encNode_Str__alloc */
-	if (!node)
-		return;
+/* Points every node of the list, up to (not including) 'stop', back at its
+ * own string
+ */
+static void encKey_Str__restore(EncList_Str *obj, EncNode_Str *stop)
+{
+	EncKey_Str_Saved *saved;
+	EncNode_Str *node;
 
-	/* Add to the end of the list */
-	tail = encList_Str__getTail(obj);
-	if (!tail)
-		obj->head = node;
-	else {
-		node->prev = tail;
-		tail->next = node;
+	for (node = obj->head; node != stop; node = node->next) {
+		saved = (EncKey_Str_Saved *)(node->str - offsetof(EncKey_Str_Saved, bytes));
+		node->str = saved->str;
+		node->key = saved->key;
+		node->len = saved->len;
 	}
 }
 
-// ---------------- count ----------------------------
-// Parameters: 'this' pointer (of the wrapper class)
-//
-// Returns the number of nodes in the list.
-//
-// ERRORS:
-//   'this' is NULL.  Print error and return -1.
-
-int encList_Str__count(EncList_Str *obj)
+static void encKey_Str__freeArena(EncKey_Str_Arena *arena)
 {
-	EncNode_Str *pos;
-	int cnt = 0;
+	EncPool_Str_Chunk *chunk;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__count: The object is NULL.\n");
-		return 0;
+	while ((chunk = arena->chunks)) {
+		arena->chunks = chunk->next;
+		free(chunk);
+		ENCLIST_STR_STAT(frees, 1);
 	}
+}
 
-	pos = obj->head;
-	while (pos) {
-		cnt++;
-		pos = pos->next;
+/* Extracts the key of every node of the list, and points the node at it
+ * (see EncKey_Str_Saved).  Returns 0 on success, or -1 if malloc() fails -
+ * and then the list is left as it was.
+ */
+static int encKey_Str__apply(EncKey_Str *key, EncList_Str *obj, EncKey_Str_Arena *arena)
+{
+	EncKey_Str_Saved *saved;
+	EncPool_Str_Chunk *chunk;
+	EncNode_Str *node;
+	size_t room, size;
+	int len;
+
+	arena->chunks = NULL;
+	arena->used = 0;
+	arena->size = 0;
+
+	for (node = obj->head; node; node = node->next) {
+		ENCLIST_STR_STAT(nodesWalked, 1);
+
+		/* Try the room left in the current chunk first */
+		arena->used = (arena->used + 7) & ~(size_t)7;
+		room = 0;
+		saved = NULL;
+		if (arena->chunks && arena->size > arena->used + sizeof(EncKey_Str_Saved)) {
+			saved = (EncKey_Str_Saved *)(arena->chunks->data + arena->used);
+			room = arena->size - arena->used - sizeof(EncKey_Str_Saved);
+			if (room > INT_MAX)
+				room = INT_MAX;
+		}
+		len = encKey_Str__extract(key, node->str, node->len, saved ? saved->bytes : NULL, (int)room);
+
+		if (len >= 0 && (!saved || (size_t)len > room)) {
+			size = sizeof(EncKey_Str_Saved) + len;
+			if (size < ENCKEY_STR_CHUNK_SIZE)
+				size = ENCKEY_STR_CHUNK_SIZE;
+
+			chunk = (EncPool_Str_Chunk *)malloc(sizeof(EncPool_Str_Chunk) + size);
+			if (!chunk) {
+				perror("malloc");
+				encKey_Str__restore(obj, node);
+				encKey_Str__freeArena(arena);
+				return -1;
+			}
+			ENCLIST_STR_STAT(mallocs, 1);
+			chunk->next = arena->chunks;
+			arena->chunks = chunk;
+			arena->used = 0;
+			arena->size = size;
+
+			saved = (EncKey_Str_Saved *)chunk->data;
+			len = encKey_Str__extract(key, node->str, node->len, saved->bytes,
+			                          (int)(size - sizeof(EncKey_Str_Saved)));
+		}
+		if (len < 0) {
+			fprintf(stderr, "encKey_Str: The key function returned %d.\n", len);
+			encKey_Str__restore(obj, node);
+			encKey_Str__freeArena(arena);
+			return -1;
+		}
+		arena->used += sizeof(EncKey_Str_Saved) + len;
+
+		saved->str = node->str;
+		saved->key = node->key;
+		saved->len = node->len;
+		node->str = saved->bytes;
+		node->len = len;
+		node->key = encNode_Str__prefix(saved->bytes, len);
 	}
-	return cnt;
+
+	return 0;
 }
 
-// ---------------- getMin/getMax ----------------------------
+// ---------------- sortBy/mergeBy ----------------------------
 // Parameters: 'this' pointer (of the wrapper class)
+//             (for mergeBy(): another list)
+//             sort key
 //
-// Searches the list for the minimum or maximum string.  This does *NOT*
-// assume that the list is sorted, and so it probably will perform a
-// brute-force scan of the entire list.
+// Equivalent to sort() and merge(), but in the order of the key (see
+// EncKey_Str above), rather than of the strings themselves.  Like sort(),
+// sortBy() is stable: strings with equal keys stay in the order they were
+// in.  For mergeBy(), both lists must already be sorted by the same key.
 //
-// Returns NULL if the list is empty.
+// Each key is extracted once, into a temporary buffer which is freed again
+// at the end; during the sort, the comparisons only ever look at the keys.
 //
 // ERRORS:
-//   'this' is NULL.  Print error and return NULL.
+//   - Any pointer is NULL.  Print error.
+//   - malloc() fails, or the function of a custom key returns an error.
+//     Print error; the list(s) are not changed.
 
-char *encList_Str__getMin(EncList_Str *obj)
+void encList_Str__sortBy(EncList_Str *obj, EncKey_Str *key)
 {
-	EncNode_Str *node;
-	char* str;
+	EncKey_Str_Arena arena;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__getMin: The object is NULL.\n");
-		return 0;
+	if (!obj || !key) {
+		fprintf(stderr, "encList_Str__sortBy: The object or key is NULL.\n");
+		return;
 	}
+	ENCLIST_STR_BEGIN();
 
-	if (!obj->head)
-		return NULL;
-
-	node = obj->head;
-	str = node->str;
-	while (node->next) {
-		node = node->next;
-		if (strcmp(str, node->str) > 0)
-			str = node->str;
+	if (encKey_Str__apply(key, obj, &arena) == 0) {
+		encList_Str__sort(obj);
+		encKey_Str__restore(obj, NULL);
+		encKey_Str__freeArena(&arena);
 	}
 
-	return str;
+	ENCLIST_STR_END("sortBy");
 }
-char *encList_Str__getMax(EncList_Str *obj)
+void encList_Str__mergeBy(EncList_Str *lhs, EncList_Str *rhs, EncKey_Str *key)
 {
-	EncNode_Str *node;
-	char* str;
+	EncKey_Str_Arena lhsArena, rhsArena;
 
-	if (!obj) {
-		fprintf(stderr, "encList_Str__getMax: The object is NULL.\n");
-		return 0;
+	if (!lhs || !rhs || !key) {
+		fprintf(stderr, "encList_Str__mergeBy: The object or key is NULL.\n");
+		return;
 	}
+	ENCLIST_STR_BEGIN();
 
-	if (!obj->head)
-		return NULL;
-
-	node = obj->head;
-	str = node->str;
-	while (node->next) {
-		node = node->next;
-		if (strcmp(str, node->str) < 0)
-			str = node->str;
+	if (encKey_Str__apply(key, lhs, &lhsArena) == 0) {
+		if (encKey_Str__apply(key, rhs, &rhsArena) < 0) {
+			encKey_Str__restore(lhs, NULL);
+			encKey_Str__freeArena(&lhsArena);
+		} else {
+			/* Afterward, lhs holds the nodes from both arenas */
+			encList_Str__merge(lhs, rhs);
+			encKey_Str__restore(lhs, NULL);
+			encKey_Str__freeArena(&lhsArena);
+			encKey_Str__freeArena(&rhsArena);
+		}
 	}
 
-	return str;
+	ENCLIST_STR_END("mergeBy");
 }
 
-// ---------------- sort ----------------------------
+// ---------------- getMinBy/getMaxBy ----------------------------
 // Parameters: 'this' pointer (of the wrapper class)
-//             another list
-//
-// This function assumes (but does not verify) that the two lists are both
-// already sorted.  It iterates through the two lists in parallel, always
-// taking the smaller value from each list and placing into the resulting,
-// merged list.
-//
-// Thus, the resulting list will be sorted when the function completes.
+//             sort key
 //
-// The merged list will be stored in the first parameter; all of the nodes
-// will be removed from the second parameter (and placed in their proper
-// locations within the first).
-//
-// EXAMPLE:
-//   Before merge():
-//       left  list: foo jkl qwerty
-//       right list: asdf bar good zzzz
-//   After merge():
-//       left  list: asdf bar foo good jkl qwerty zzzz
-//       right list: <empty>
+// Equivalent to getMin() and getMax(), but in the order of the key.  Only
+// two keys are kept at a time: the best so far, and the one being looked at.
 //
-// NOTE: Strings must *NOT* be copied back and forth between nodes!
-//       This function *ONLY* changes the next/prev arrows that link nodes!
+// Returns NULL if the list is empty.
 //
 // ERRORS:
-//   Either pointer is NULL.  Print error.
+//   - Either pointer is NULL.  Print error and return NULL.
+//   - malloc() fails, or the function of a custom key returns an error.
+//     Print error and return NULL.
 
-void encList_Str__merge(EncList_Str *lhs, EncList_Str *rhs)
+/* Extracts the key of a node into *buf (growing it if needed), and returns
+ * its length; or -1 if the buffer could not be grown, or the key function
+ * failed
+ */
+static int encKey_Str__extractInto(EncKey_Str *key, EncNode_Str *node, char **buf, int *cap)
 {
-	EncList_Str obj = { NULL };
-	EncNode_Str *head = NULL, *pos = NULL;
+	char *grown;
+	int len;
 
-	if (!lhs || !rhs) {
-		fprintf(stderr, "encList_Str__merge: The object is NULL.\n");
-		return;
+	len = encKey_Str__extract(key, node->str, node->len, *buf, *cap);
+	if (len < 0) {
+		fprintf(stderr, "encKey_Str: The key function returned %d.\n", len);
+		return -1;
 	}
+	if (len > *cap) {
+		grown = (char *)realloc(*buf, len);
+		if (!grown) {
+			perror("realloc");
+			return -1;
+		}
+		if (!*buf)
+			ENCLIST_STR_STAT(mallocs, 1);
+		*buf = grown;
+		*cap = len;
+		len = encKey_Str__extract(key, node->str, node->len, *buf, *cap);
+	}
+	return len;
+}
 
-	/* Start from heads of two lists */
-	while (lhs->head && rhs->head) {
-		EncNode_Str *node;
+/* Finds the node with the smallest key (sign > 0) or the largest (sign < 0) */
+static EncNode_Str *encList_Str__findBy(EncList_Str *obj, EncKey_Str *key, int sign)
+{
+	EncNode_Str *node, *best;
+	char *bestBuf = NULL, *buf = NULL, *tmp;
+	int bestCap = 0, cap = 0, bestLen, len, cmp, tmpCap;
 
-		/* Get the minimum node and remove from list */
-		if (strcmp(lhs->head->str, rhs->head->str) <= 0)
-			node = encList_Str__popHead(lhs);
-		else
-			node = encList_Str__popHead(rhs);
+	best = obj->head;
+	bestLen = encKey_Str__extractInto(key, best, &bestBuf, &bestCap);
+	for (node = best->next; node && bestLen >= 0; node = node->next) {
+		ENCLIST_STR_STAT(nodesWalked, 1);
+		len = encKey_Str__extractInto(key, node, &buf, &cap);
+		if (len < 0) {
+			bestLen = -1;
+			break;
+		}
 
-		/* Append to the temporary list */
-		if (!head) {
-			head = node;
-			pos = node;
-		} else {
-			encNode_Str__addAfter(pos, node);
-			pos = pos->next;
+		ENCLIST_STR_STAT(compares, 1);
+		cmp = memcmp(bestBuf, buf, bestLen < len ? bestLen : len);
+		if (!cmp)
+			cmp = (bestLen > len) - (bestLen < len);
+		if (cmp * sign > 0) {
+			best = node;
+			tmp = bestBuf;
+			bestBuf = buf;
+			buf = tmp;
+			tmpCap = bestCap;
+			bestCap = cap;
+			cap = tmpCap;
+			bestLen = len;
 		}
 	}
 
-	/* Append the list that has not yet been fully merged */
-	obj.head = head;
-	if (lhs->head)
-		encList_Str__append(&obj, lhs);
-	else if (rhs->head)
-		encList_Str__append(&obj, rhs);
+	if (bestBuf)
+		ENCLIST_STR_STAT(frees, 1);
+	if (buf)
+		ENCLIST_STR_STAT(frees, 1);
+	free(bestBuf);
+	free(buf);
+	return bestLen < 0 ? NULL : best;
+}
+
+char *encList_Str__getMinBy(EncList_Str *obj, EncKey_Str *key)
+{
+	EncNode_Str *min;
+
+	if (!obj || !key) {
+		fprintf(stderr, "encList_Str__getMinBy: The object or key is NULL.\n");
+		return NULL;
+	}
 
-	/* Assertion */
-	if (lhs->head || rhs->head)
-		fprintf(stderr, "encList_Str__merge: Internal error.\n");
+	if (!obj->head)
+		return NULL;
 
-	/* Assign the new head to lhs anyway */
-	lhs->head = obj.head;
+	ENCLIST_STR_BEGIN();
+	min = encList_Str__findBy(obj, key, 1);
+	ENCLIST_STR_END("getMinBy");
+
+	return min ? min->str : NULL;
+}
+char *encList_Str__getMaxBy(EncList_Str *obj, EncKey_Str *key)
+{
+	EncNode_Str *max;
+
+	if (!obj || !key) {
+		fprintf(stderr, "encList_Str__getMaxBy: The object or key is NULL.\n");
+		return NULL;
+	}
+
+	if (!obj->head)
+		return NULL;
+
+	ENCLIST_STR_BEGIN();
+	max = encList_Str__findBy(obj, key, -1);
+	ENCLIST_STR_END("getMaxBy");
+
+	return max ? max->str : NULL;
 }
 
 // ---------------- append ----------------------------
@@ -431,20 +3653,42 @@ void encList_Str__append(EncList_Str *lhs, EncList_Str *rhs)
 	}
 
 	/* Get tail of first list, and head of second list */
-	tail = encList_Str__getTail(lhs);
-	head = encList_Str__getHead(rhs);
+	tail = lhs->tail;
+	head = rhs->head;
+
+	/* Nothing to move */
+	if (!head)
+		return;
+
+	/* The fingers of the other list carry over (shifted), if it has them */
+	if (lhs->index && lhs->index->valid) {
+		EncList_Str_Index *idx = rhs->index;
+		int i;
+
+		if (idx && idx->valid) {
+			for (i = 0; i < idx->n && lhs->index->valid; i++) {
+				encList_Str__indexPushBack(lhs->index, ENCLIST_STR_FINGER(idx, i).node,
+				                           lhs->count + ENCLIST_STR_FINGER(idx, i).pos + idx->base);
+			}
+		} else
+			encList_Str__indexDirty(lhs);
+	}
 
 	/* Append to the first list */
 	if (!tail) {
 		lhs->head = head;
 	} else {
 		tail->next = head;
-		if (head)
-			head->prev = tail;
+		head->prev = tail;
 	}
+	lhs->tail = rhs->tail;
+	lhs->count += rhs->count;
 
 	/* Empty the other list */
 	rhs->head = NULL;
+	rhs->tail = NULL;
+	rhs->count = 0;
+	encList_Str__indexClear(rhs);
 }
 
 // ---------------- index ---------------------------------
@@ -455,6 +3699,9 @@ void encList_Str__append(EncList_Str *lhs, EncList_Str *rhs)
 // node immediately after the head.
 //
 // Just like an array, the valid indices are 0 through count()-1, inclusive.
+// The search starts from whichever end of the list is closer to the index -
+// or, if the list has a finger index (see setIndex() below), from whichever
+// finger is closest, in either direction.
 //
 // ERRORS:
 //   - Pointer is NULL.  Print error and return NULL.
@@ -474,21 +3721,144 @@ EncNode_Str *encList_Str__index(EncList_Str *obj, int index)
 		return NULL;
 	}
 
-	pos = obj->head;
-	idx = 0;
-	while (pos && (idx < index)) {
+	if (index >= obj->count) {
+		fprintf(stderr, "encList_Str__index: The index is too large.\n");
+		return NULL;
+	}
+	ENCLIST_STR_BEGIN();
+
+	/* Start from the closer end of the list... */
+	if (index <= obj->count / 2) {
+		pos = obj->head;
+		idx = 0;
+	} else {
+		pos = obj->tail;
+		idx = obj->count - 1;
+	}
+
+	/* ...or from a closer finger: binary search for the last finger at
+	 * or before the index, and then try it and the one after it
+	 */
+	if (obj->index) {
+		EncList_Str_Index *fi = obj->index;
+		int lo = 0, hi, i;
+
+		if (!fi->valid)
+			encList_Str__indexRebuild(obj);
+
+		hi = fi->valid ? fi->n : 0;
+		while (hi - lo > 1) {
+			int mid = (lo + hi) / 2;
+
+			if (ENCLIST_STR_FINGER(fi, mid).pos + fi->base <= index)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		for (i = lo; i <= lo + 1 && fi->valid && i < fi->n; i++) {
+			int fpos = ENCLIST_STR_FINGER(fi, i).pos + fi->base;
+
+			if (abs(fpos - index) < abs(idx - index)) {
+				pos = ENCLIST_STR_FINGER(fi, i).node;
+				idx = fpos;
+			}
+		}
+	}
+
+	ENCLIST_STR_STAT(nodesWalked, abs(index - idx));
+	while (idx < index) {
 		pos = pos->next;
 		idx++;
 	}
-
-	if (!pos) {
-		fprintf(stderr, "encList_Str__index: The index is too large.\n");
-		return NULL;
+	while (idx > index) {
+		pos = pos->prev;
+		idx--;
 	}
+	ENCLIST_STR_END("index");
 
 	return pos;
 }
 
+// ---------------- setIndex ---------------------------------
+// Parameters: 'this' pointer (for the wrapper object)
+//             spacing (one finger for every 'spacing' nodes; 0 to turn off)
+//
+// Adds an optional "finger" index to the list, which makes index() and
+// splitAt() take O(log N + spacing) steps, instead of O(N).  A finger is a
+// saved pointer to a node, along with its position; the index keeps one
+// finger for about every 'spacing' nodes, so it costs about 16/spacing bytes
+// per node.  index() starts from the closest finger (or end of the list),
+// and walks forward or backward from there.
+//
+// addHead(), addTail(), popHead(), append() and splitAt() keep the fingers
+// up to date as they go, in O(1) (or O(fingers moved)).  The methods which
+// reorder the whole list - merge(), mergeK() and the sorts - just mark the
+// index as stale; it is rebuilt (in one pass) the next time it is needed.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+//   - malloc() fails.  Print error; the list simply has no index.
+
+void encList_Str__setIndex(EncList_Str *obj, int spacing)
+{
+	if (!obj) {
+		fprintf(stderr, "encList_Str__setIndex: The object is NULL.\n");
+		return;
+	}
+
+	/* Turn the index off */
+	if (spacing <= 0) {
+		encList_Str__indexFree(obj);
+		return;
+	}
+
+	if (!obj->index) {
+		obj->index = (EncList_Str_Index *)calloc(1, sizeof(EncList_Str_Index));
+		if (!obj->index) {
+			perror("calloc");
+			return;
+		}
+		ENCLIST_STR_STAT(mallocs, 1);
+
+		if (obj->pool) {
+			obj->index->nextPooled = obj->pool->indexes;
+			if (obj->pool->indexes)
+				obj->pool->indexes->prevPooled = obj->index;
+			obj->pool->indexes = obj->index;
+		}
+	}
+	obj->index->spacing = spacing;
+	obj->index->valid = 0;
+}
+
+// ---------------- setIntern ---------------------------------
+// Parameters: 'this' pointer (of the wrapper class)
+//             interner (or NULL)
+//
+// Makes the list share the strings it copies (dup=1) from the given
+// interner - see EncIntern_Str above - or, with NULL, go back to copying
+// them one by one.  Only the nodes added from now on are affected; the
+// nodes already on the list keep their strings as they are.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+//   - The list comes from a pool (see EncIntern_Str above), and the interner
+//     is not NULL.  Print error; the list is not changed.
+
+void encList_Str__setIntern(EncList_Str *obj, EncIntern_Str *intern)
+{
+	if (!obj) {
+		fprintf(stderr, "encList_Str__setIntern: The object is NULL.\n");
+		return;
+	}
+	if (obj->pool && intern) {
+		fprintf(stderr, "encList_Str__setIntern: A list from a pool cannot use an interner.\n");
+		return;
+	}
+
+	obj->intern = intern;
+}
+
 // ---------------- splitAt ----------------------------
 // Parameters: 'this' pointer (of the wrapper class)
 //             index into the list
@@ -521,20 +3891,24 @@ EncList_Str *encList_Str__splitAt(EncList_Str *obj, int index)
 		return NULL;
 	}
 
-	count = encList_Str__count(obj);
+	count = obj->count;
 	if (index < 0 || index > count) {
 		fprintf(stderr, "encList_Str__splitAt: The index is invalid.\n");
 		return NULL;
 	}
+	ENCLIST_STR_BEGIN();
 
-	newObj = encList_Str__alloc();
-	/* Errors should be handled in encList_Str__alloc */
-	if (!newObj)
-		return NULL;
-
-	/* Move nothing into the new list */
-	if (index == count)
+	if (obj->pool)
+		newObj = encList_Str__allocPool(obj->pool);
+	else
+		newObj = encList_Str__alloc();
+	/* Errors should be handled in encList_Str__alloc/allocPool; and if
+	 * index == count, there is nothing to move into the new list
+	 */
+	if (!newObj || index == count) {
+		ENCLIST_STR_END("splitAt");
 		return newObj;
+	}
 
 	node = encList_Str__index(obj, index);
 
@@ -545,8 +3919,30 @@ EncList_Str *encList_Str__splitAt(EncList_Str *obj, int index)
 		obj->head = NULL;
 
 	/* Append node to the new list as head */
-	node->prev = NULL;
 	newObj->head = node;
+	newObj->tail = obj->tail;
+	newObj->count = count - index;
+
+	obj->tail = node->prev;
+	obj->count = index;
+	node->prev = NULL;
+
+	/* The new list gets an index too, with the fingers that moved */
+	if (obj->index) {
+		EncList_Str_Index *idx = obj->index;
+
+		encList_Str__setIndex(newObj, idx->spacing);
+		if (idx->valid && newObj->index) {
+			encList_Str__indexClear(newObj);
+			while (idx->n && ENCLIST_STR_FINGER(idx, idx->n - 1).pos + idx->base >= index) {
+				encList_Str__indexPushFront(newObj->index, ENCLIST_STR_FINGER(idx, idx->n - 1).node,
+				                            ENCLIST_STR_FINGER(idx, idx->n - 1).pos + idx->base - index);
+				idx->n--;
+			}
+		} else
+			idx->n = 0;
+	}
+	ENCLIST_STR_END("splitAt");
 
 	return newObj;
 }
@@ -574,19 +3970,12 @@ EncNode_Str *encList_Str__getHead(EncList_Str *obj)
 }
 EncNode_Str *encList_Str__getTail(EncList_Str *obj)
 {
-	EncNode_Str *node;
-
 	if (!obj) {
 		fprintf(stderr, "encList_Str__getTail: The object is NULL.\n");
 		return NULL;
 	}
 
-	/* Search toward the tail of the list */
-	node = obj->head;
-	while (node && node->next)
-		node = node->next;
-
-	return node;
+	return obj->tail;
 }
 
 
@@ -594,7 +3983,9 @@ EncNode_Str *encList_Str__getTail(EncList_Str *obj)
 // Parameters: 'this' pointer (for the NODE!)
 //
 // Returns various properties of the list node.  next/prev will return NULL
-// when we hit the extreme of the list.
+// when we hit the extreme of the list.  getLen() returns the length of the
+// string.  For a list from mapFile(), the string from getStr() is not
+// terminated with a NUL, and getLen() is the only way to find its end.
 //
 // ERRORS:
 //   - None
@@ -604,6 +3995,10 @@ char *encNode_Str__getStr(EncNode_Str *node)
 {
 	return node->str;
 }
+int encNode_Str__getLen(EncNode_Str *node)
+{
+	return node->len;
+}
 EncNode_Str *encNode_Str__getNext(EncNode_Str *node)
 {
 	return node->next;
@@ -612,3 +4007,475 @@ EncNode_Str *encNode_Str__getPrev(EncNode_Str *node)
 {
 	return node->prev;
 }
+
+
+// ---------------- cursor ---------------------------------
+// Parameters: 'this' pointer (for the wrapper object), and the cursor to set
+//
+// Sets the cursor to the head of the list.  The cursor is a plain struct,
+// owned by the caller (it can live on the stack); it holds nothing but the
+// next node to visit, so the list must not be changed while a cursor on it
+// is in use.
+//
+// cursorNext(): Returns the string at the cursor, and steps to the next
+// node.  Returns NULL once the end of the list is reached.
+//
+// cursorNextN(): Fills out[] with up to 'n' strings from the cursor, and
+// steps past them; returns how many it stored (0 at the end of the list).
+// While it walks, it prefetches the strings a few nodes ahead, so that a
+// caller which looks at each string doesn't wait on every one of them in
+// turn.
+//
+// The cursor hands back only the strings, not their lengths; so for a list
+// from mapFile(), whose strings are not terminated with a NUL, walk the
+// nodes with getNext() and getLen() instead.
+//
+// (See encapsulatedListStrCursor.h for inline versions of the last two.)
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error and return (the cursor, if any,
+//     is set to the end).
+//   - For cursorNext()/cursorNextN(): the cursor (or out[]) is NULL.  Print
+//     error and return NULL (or 0).
+
+void encList_Str__cursor(EncList_Str *obj, EncList_Str_Cursor *cur)
+{
+	if (!obj || !cur) {
+		fprintf(stderr, "encList_Str__cursor: The object or cursor is NULL.\n");
+		if (cur)
+			cur->node = NULL;
+		return;
+	}
+
+	cur->node = obj->head;
+}
+char *encList_Str__cursorNext(EncList_Str_Cursor *cur)
+{
+	if (!cur) {
+		fprintf(stderr, "encList_Str__cursorNext: The cursor is NULL.\n");
+		return NULL;
+	}
+
+	return encList_Str__cursorNextFast(cur);
+}
+int encList_Str__cursorNextN(EncList_Str_Cursor *cur, char **out, int n)
+{
+	int got;
+
+	if (!cur || !out) {
+		fprintf(stderr, "encList_Str__cursorNextN: The cursor or array is NULL.\n");
+		return 0;
+	}
+
+	got = encList_Str__cursorNextNFast(cur, out, n);
+	ENCLIST_STR_STAT(nodesWalked, got);
+	return got;
+}
+
+
+// ------------- EncStack_Str / EncQueue_Str (concurrent) ---------------
+//
+// Two containers for handing strings from thread to thread, which - unlike
+// EncList_Str - may be used by any number of threads at once, without any
+// locking by the caller.  Both hold ordinary (malloc()ed) nodes: a node that
+// is taken off of one belongs to the caller, and can be added to a list,
+// or freed with encNode_Str__free().
+//
+// EncStack_Str is a lock-free stack (LIFO): pushHead() and popHead() each
+// take one compare-and-swap of the top, which never blocks.  The top is a
+// pointer *and* a tag that counts every change, swapped together with a
+// 16-byte CAS, so that a popHead() which reads the top, is delayed while
+// that node is popped and pushed back, and then tries its CAS, fails
+// instead of corrupting the stack (the "ABA" problem).  (Link with
+// -latomic.)
+//
+// EncQueue_Str is a two-lock queue (FIFO): addTail() only takes the tail
+// lock, and popHead() only takes the head lock - so producers and a
+// consumer don't wait for each other, except when the queue holds at most
+// one node.
+//
+// For both, drain() moves every node into an EncList_Str all at once, in
+// the order that they were added; so a consumer can take a whole batch,
+// and then sort it or walk it without touching the shared object again.
+// The list must not use a pool.
+//
+// NOTE: A popHead() on the stack which loses a race may still read the
+//       'next' arrow of a node that another thread has just popped (the
+//       tag makes sure that it never uses the value).  So with more than one
+//       consumer, a node must not be freed while another thread could be
+//       in popHead().  With one consumer (any number of producers), there
+//       is no such race.
+
+typedef struct EncList_Str_Top EncList_Str_Top;
+struct EncList_Str_Top {
+	EncNode_Str	*node;
+	uintptr_t	tag;
+} __attribute__((aligned(16)));
+
+struct EncapsulatedList_Str_Stack {
+	EncList_Str_Top		top;
+};
+
+/* The head and tail ends are on separate cache lines, so that producers
+ * and consumers don't fight over them.  'dummy' is never on a list: its
+ * 'next' is the first node, and 'tail' points at it when the queue is empty.
+ */
+struct EncapsulatedList_Str_Queue {
+	EncNode_Str		dummy;
+	pthread_mutex_t		headLock;
+	EncNode_Str		*tail __attribute__((aligned(64)));
+	pthread_mutex_t		tailLock;
+};
+
+// ------------- alloc() - Constructor ---------------
+// Parameters: None
+//
+// Allocates a new, empty stack or queue.
+//
+// ERRORS:
+//   - malloc() fails.  Print error and return NULL
+
+EncStack_Str *encStack_Str__alloc()
+{
+	EncStack_Str *obj;
+
+	/* The top must be 16-byte aligned for the CAS */
+	if (posix_memalign((void **)&obj, 64, sizeof(EncStack_Str))) {
+		perror("posix_memalign");
+		return NULL;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	obj->top.node = NULL;
+	obj->top.tag = 0;
+
+	return obj;
+}
+EncQueue_Str *encQueue_Str__alloc()
+{
+	EncQueue_Str *obj;
+
+	if (posix_memalign((void **)&obj, 64, sizeof(EncQueue_Str))) {
+		perror("posix_memalign");
+		return NULL;
+	}
+	ENCLIST_STR_STAT(mallocs, 1);
+
+	memset(&obj->dummy, 0, sizeof(EncNode_Str));
+	obj->tail = &obj->dummy;
+	pthread_mutex_init(&obj->headLock, NULL);
+	pthread_mutex_init(&obj->tailLock, NULL);
+
+	return obj;
+}
+
+// -------------- free() - Destructor ----------------
+// Parameters: 'this' pointer
+//
+// Frees the stack or queue, and every node still on it.  No other thread
+// may be using it.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error.
+
+void encStack_Str__free(EncStack_Str *obj)
+{
+	EncNode_Str *node, *next;
+
+	if (!obj) {
+		fprintf(stderr, "encStack_Str__free: The object is NULL.\n");
+		return;
+	}
+
+	for (node = obj->top.node; node; node = next) {
+		next = node->next;
+		node->next = NULL;
+		encNode_Str__free(node);
+	}
+	free(obj);
+	ENCLIST_STR_STAT(frees, 1);
+}
+void encQueue_Str__free(EncQueue_Str *obj)
+{
+	EncNode_Str *node, *next;
+
+	if (!obj) {
+		fprintf(stderr, "encQueue_Str__free: The object is NULL.\n");
+		return;
+	}
+
+	for (node = obj->dummy.next; node; node = next) {
+		next = node->next;
+		node->prev = NULL;
+		node->next = NULL;
+		encNode_Str__free(node);
+	}
+	pthread_mutex_destroy(&obj->headLock);
+	pthread_mutex_destroy(&obj->tailLock);
+	free(obj);
+	ENCLIST_STR_STAT(frees, 1);
+}
+
+// ---------------- pushHead/popHead (stack) -----------------
+// Parameters: 'this' pointer
+//             *string*, dup (pushHead() only; just like for addHead())
+//
+// pushHead() adds a new node holding the string on the top of the stack.
+// popHead() takes the node off of the top, and returns it (the caller owns
+// it now); it returns NULL if the stack is empty.  Neither one blocks.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error (popHead(): and return NULL).
+//   - malloc() fails.  Print error; the stack is not changed.
+
+void encStack_Str__pushHead(EncStack_Str *obj, char *string, int dup)
+{
+	EncList_Str_Top old, top;
+	EncNode_Str *node;
+
+	if (!obj) {
+		fprintf(stderr, "encStack_Str__pushHead: The object is NULL.\n");
+		return;
+	}
+
+	node = encNode_Str__alloc(string, dup);
+	/* Errors should be handled in encNode_Str__alloc */
+	if (!node)
+		return;
+
+	__atomic_load(&obj->top, &old, __ATOMIC_RELAXED);
+	do {
+		node->next = old.node;
+		top.node = node;
+		top.tag = old.tag + 1;
+	} while (!__atomic_compare_exchange(&obj->top, &old, &top, 1,
+	                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+EncNode_Str *encStack_Str__popHead(EncStack_Str *obj)
+{
+	EncList_Str_Top old, top;
+
+	if (!obj) {
+		fprintf(stderr, "encStack_Str__popHead: The object is NULL.\n");
+		return NULL;
+	}
+
+	__atomic_load(&obj->top, &old, __ATOMIC_ACQUIRE);
+	while (old.node) {
+		top.node = __atomic_load_n(&old.node->next, __ATOMIC_RELAXED);
+		top.tag = old.tag + 1;
+		if (__atomic_compare_exchange(&obj->top, &old, &top, 1,
+		                              __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+			break;
+	}
+
+	if (old.node)
+		__atomic_store_n(&old.node->next, NULL, __ATOMIC_RELAXED);
+	return old.node;
+}
+
+// ---------------- addTail/popHead (queue) ------------------
+// Parameters: 'this' pointer
+//             *string*, dup (addTail() only; just like for addTail())
+//
+// addTail() adds a new node holding the string at the tail of the queue.
+// popHead() takes the node off of the head, and returns it (the caller owns
+// it now); it returns NULL if the queue is empty.
+//
+// ERRORS:
+//   - Pointer is NULL.  Print error (popHead(): and return NULL).
+//   - malloc() fails.  Print error; the queue is not changed.
+
+void encQueue_Str__addTail(EncQueue_Str *obj, char *string, int dup)
+{
+	EncNode_Str *node;
+
+	if (!obj) {
+		fprintf(stderr, "encQueue_Str__addTail: The object is NULL.\n");
+		return;
+	}
+
+	/* Allocate outside of the lock */
+	node = encNode_Str__alloc(string, dup);
+	/* Errors should be handled in encNode_Str__alloc */
+	if (!node)
+		return;
+
+	pthread_mutex_lock(&obj->tailLock);
+	node->prev = obj->tail;
+	/* popHead() may be reading this arrow without the tail lock */
+	__atomic_store_n(&obj->tail->next, node, __ATOMIC_RELEASE);
+	obj->tail = node;
+	pthread_mutex_unlock(&obj->tailLock);
+}
+EncNode_Str *encQueue_Str__popHead(EncQueue_Str *obj)
+{
+	EncNode_Str *node, *next;
+
+	if (!obj) {
+		fprintf(stderr, "encQueue_Str__popHead: The object is NULL.\n");
+		return NULL;
+	}
+
+	pthread_mutex_lock(&obj->headLock);
+	node = __atomic_load_n(&obj->dummy.next, __ATOMIC_ACQUIRE);
+	if (node) {
+		next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+		if (next)
+			obj->dummy.next = next;
+		else {
+			/* This may be the last node, so the tail has to move too -
+			 * unless a node was added after it in the meantime
+			 */
+			pthread_mutex_lock(&obj->tailLock);
+			next = node->next;
+			if (!next)
+				obj->tail = &obj->dummy;
+			obj->dummy.next = next;
+			pthread_mutex_unlock(&obj->tailLock);
+		}
+		node->prev = NULL;
+		node->next = NULL;
+	}
+	pthread_mutex_unlock(&obj->headLock);
+
+	return node;
+}
+
+// ---------------- drain -----------------------------------
+// Parameters: 'this' pointer (for the stack or queue)
+//             list (to move the nodes to)
+//
+// Takes every node off of the stack or queue at once, and adds them to the
+// tail of the list, in the order in which they were added (oldest first -
+// so a stack is reversed).  Returns the number of nodes moved.
+//
+// The stack is emptied with a single swap of its top; the queue holds both
+// of its locks just long enough to unhook the chain.  The nodes are then
+// linked into the list without holding anything.  The list must not use a
+// pool, and must not be shared with other threads.
+//
+// ERRORS:
+//   - Either pointer is NULL.  Print error and return -1.
+//   - The list comes from a pool.  Print error and return -1; the stack or
+//     queue is not changed.
+
+int encStack_Str__drain(EncStack_Str *obj, EncList_Str *list)
+{
+	EncList_Str_Top old, top;
+	EncNode_Str *node, *next, *first = NULL, *last;
+	int n = 0;
+
+	if (!obj || !list) {
+		fprintf(stderr, "encStack_Str__drain: The object or list is NULL.\n");
+		return -1;
+	}
+	if (list->pool) {
+		fprintf(stderr, "encStack_Str__drain: The list comes from a pool.\n");
+		return -1;
+	}
+
+	/* The tag has to move on, so this is a CAS rather than an exchange;
+	 * it only loops if another thread changes the top at the same moment
+	 */
+	__atomic_load(&obj->top, &old, __ATOMIC_ACQUIRE);
+	do {
+		top.node = NULL;
+		top.tag = old.tag + 1;
+	} while (!__atomic_compare_exchange(&obj->top, &old, &top, 1,
+	                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+	if (!old.node)
+		return 0;
+
+	/* Newest first; reverse it, and fill in the 'prev' arrows */
+	last = old.node;
+	for (node = old.node; node; node = next) {
+		next = node->next;
+		node->next = first;
+		if (first)
+			first->prev = node;
+		first = node;
+		n++;
+	}
+	first->prev = NULL;
+
+	encList_Str__spliceTail(list, first, last, n);
+	return n;
+}
+int encQueue_Str__drain(EncQueue_Str *obj, EncList_Str *list)
+{
+	EncNode_Str *first, *last, *node;
+	int n = 0;
+
+	if (!obj || !list) {
+		fprintf(stderr, "encQueue_Str__drain: The object or list is NULL.\n");
+		return -1;
+	}
+	if (list->pool) {
+		fprintf(stderr, "encQueue_Str__drain: The list comes from a pool.\n");
+		return -1;
+	}
+
+	pthread_mutex_lock(&obj->headLock);
+	pthread_mutex_lock(&obj->tailLock);
+	first = obj->dummy.next;
+	last = obj->tail;
+	obj->dummy.next = NULL;
+	obj->tail = &obj->dummy;
+	pthread_mutex_unlock(&obj->tailLock);
+	pthread_mutex_unlock(&obj->headLock);
+
+	if (!first)
+		return 0;
+
+	for (node = first; node; node = node->next)
+		n++;
+	encList_Str__spliceTail(list, first, last, n);
+	return n;
+}
+
+
+// ---------------- getStats/resetStats/setTrace ------------------
+// Parameters: getStats():  where to store the counts
+//             resetStats(): None
+//             setTrace():  trace hook (NULL to turn tracing off)
+//
+// Instrumentation; see listStats.h.  getStats() takes a snapshot of the
+// counts for the calling thread, and resetStats() sets them back to zero.
+// setTrace() installs a hook which is called (by the thread which called
+// the method) at the end of free(), addTailN(), getMin(), getMax(), merge(),
+// mergeK(), index(), splitAt() and the sorts, with the counts for that call.
+//
+// Unless the program was built with -DLIST_STATS, getStats() always reports
+// zeros, and the hook is never called.
+//
+// ERRORS:
+//   - getStats(): Pointer is NULL.  Print error.
+
+void encList_Str__getStats(ListStats *stats)
+{
+	if (!stats) {
+		fprintf(stderr, "encList_Str__getStats: The pointer is NULL.\n");
+		return;
+	}
+
+#ifdef LIST_STATS
+	*stats = encList_Str__stats;
+#else
+	memset(stats, 0, sizeof(ListStats));
+#endif
+}
+void encList_Str__resetStats()
+{
+#ifdef LIST_STATS
+	memset(&encList_Str__stats, 0, sizeof(ListStats));
+#endif
+}
+void encList_Str__setTrace(ListStats_Trace hook)
+{
+#ifdef LIST_STATS
+	encList_Str__trace = hook;
+#else
+	(void)hook;
+#endif
+}
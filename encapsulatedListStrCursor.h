@@ -0,0 +1,112 @@
+/*
+ * encapsulatedListStrCursor.h
+ * Author:Qiwei Li
+ *
+ * Cursors over an EncList_Str: a faster way to walk a list from head to tail
+ * than calling encNode_Str__getNext() and encNode_Str__getStr() for every
+ * node.  encList_Str__cursorNextN() hands back the strings in batches, and
+ * prefetches the strings (and nodes) that come next while it goes.  Only the
+ * strings are handed back, so a cursor is no use on a list from
+ * encList_Str__mapFile(), whose strings have no NUL to end them; read those
+ * with encNode_Str__getLen().
+ *
+ * Code which is built along with the list class (the benchmarks, say) can
+ * #define ENCLIST_STR_INTERNAL before including this file.  That makes the
+ * layout of a node visible, along with inline versions of the cursor methods
+ * (the ...Fast() functions), which skip the NULL checks and the function
+ * call.  Everyone else should stick to the out-of-line methods: the layout
+ * of a node may change at any time.
+ */
+
+#ifndef __ENCAPSULATEDLISTSTRCURSOR_H__
+#define __ENCAPSULATEDLISTSTRCURSOR_H__
+
+#include "encapsulatedListStr.h"
+
+/* Cursor; see encList_Str__cursor().  'node' is the next node to visit, or
+ * NULL at the end of the list.
+ */
+typedef struct EncList_Str_Cursor EncList_Str_Cursor;
+struct EncList_Str_Cursor {
+	EncNode_Str	*node;
+};
+
+void encList_Str__cursor(EncList_Str *obj, EncList_Str_Cursor *cur);
+char *encList_Str__cursorNext(EncList_Str_Cursor *cur);
+int encList_Str__cursorNextN(EncList_Str_Cursor *cur, char **out, int n);
+
+
+#ifdef ENCLIST_STR_INTERNAL
+
+#include <stdint.h>
+
+/* Strings shorter than ENCNODE_STR_INLINE bytes (counting the terminating
+ * NUL) are copied into the node itself when dup is set, so that the node and
+ * its string are a single allocation.  'str' always points at the string,
+ * wherever it lives, and 'len' caches its length.
+ *
+ * 'key' holds the first ENCNODE_STR_PREFIX bytes of the string (zero padded),
+ * as a big-endian integer; comparing two keys as integers gives the same
+ * order as comparing those bytes with strcmp().  All together, a node is 64
+ * bytes: one cache line.
+ */
+#define ENCNODE_STR_INLINE	24
+#define ENCNODE_STR_PREFIX	8
+
+struct EncapsulatedList_Str_Node {
+	EncNode_Str	*next;
+	EncNode_Str	*prev;
+	uint64_t	key;
+	char		*str;
+	unsigned int	len;
+	int		flags;
+	char		inl[ENCNODE_STR_INLINE];
+};
+
+/* How many nodes ahead cursorNextN() prefetches the string for.  (The node
+ * itself can't be fetched any earlier than the link to it is read; but the
+ * string, when it is not inline, is a second miss which can overlap with the
+ * next ones.)
+ */
+#define ENCLIST_STR_CURSOR_AHEAD	4
+
+static inline char *encList_Str__cursorNextFast(EncList_Str_Cursor *cur)
+{
+	EncNode_Str *node = cur->node;
+
+	if (!node)
+		return NULL;
+	cur->node = node->next;
+	return node->str;
+}
+
+static inline int encList_Str__cursorNextNFast(EncList_Str_Cursor *cur, char **out, int n)
+{
+	EncNode_Str *node = cur->node;
+	EncNode_Str *ahead = node;
+	int got = 0, i;
+
+	/* 'ahead' runs ENCLIST_STR_CURSOR_AHEAD nodes in front of 'node',
+	 * touching the next node and the string of each one it passes
+	 */
+	for (i = 0; i < ENCLIST_STR_CURSOR_AHEAD && ahead; i++) {
+		__builtin_prefetch(ahead->str);
+		ahead = ahead->next;
+	}
+
+	while (got < n && node) {
+		if (ahead) {
+			__builtin_prefetch(ahead->str);
+			ahead = ahead->next;
+		}
+		out[got++] = node->str;
+		node = node->next;
+	}
+
+	cur->node = node;
+	return got;
+}
+
+#endif
+
+#endif
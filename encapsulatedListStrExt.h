@@ -0,0 +1,96 @@
+/*
+ * encapsulatedListStrExt.h
+ * Author:Qiwei Li
+ *
+ * Everything that EncList_Str offers beyond the methods declared in
+ * encapsulatedListStr.h.  Each method is documented where it is defined, in
+ * encapsulatedListStr.c.
+ *
+ * (See encapsulatedListStrCursor.h for cursors.)
+ */
+
+#ifndef __ENCAPSULATEDLISTSTREXT_H__
+#define __ENCAPSULATEDLISTSTREXT_H__
+
+#include "encapsulatedListStr.h"
+#include "listStats.h"
+
+typedef struct EncapsulatedList_Str_Pool EncPool_Str;
+typedef struct EncapsulatedList_Str_Intern EncIntern_Str;
+typedef struct EncapsulatedList_Str_Key EncKey_Str;
+typedef struct EncapsulatedList_Str_Stack EncStack_Str;
+typedef struct EncapsulatedList_Str_Queue EncQueue_Str;
+
+/* Key extractor for encKey_Str__allocCustom() */
+typedef int (*EncKey_Str_Fn)(const char *str, int len, char *key, int cap, void *arg);
+
+
+/* Nodes */
+void encNode_Str__free(EncNode_Str *node);
+EncNode_Str *encList_Str__popHead(EncList_Str *obj);
+
+/* Pools, and lists which allocate from them */
+EncPool_Str *encPool_Str__alloc();
+void encPool_Str__free(EncPool_Str *pool);
+EncList_Str *encList_Str__allocPool(EncPool_Str *pool);
+
+/* Lists read from (or saved to) files */
+EncList_Str *encList_Str__mapFile(EncPool_Str *pool, char *path);
+int encList_Str__save(EncList_Str *obj, char *path);
+EncList_Str *encList_Str__load(EncPool_Str *pool, char *path);
+
+int encNode_Str__getLen(EncNode_Str *node);
+void encList_Str__addTailN(EncList_Str *obj, char **strings, int n, int dup);
+
+/* Sorting and merging */
+void encList_Str__sort(EncList_Str *obj);
+void encList_Str__sortNatural(EncList_Str *obj);
+void encList_Str__sortParallel(EncList_Str *obj, int nthreads);
+void encList_Str__sortRadix(EncList_Str *obj);
+void encList_Str__mergeK(EncList_Str **lists, int k);
+
+/* De-duplication (of sorted lists) */
+int encList_Str__unique(EncList_Str *obj);
+int encList_Str__group(EncList_Str *obj, int **counts);
+void encList_Str__mergeUnique(EncList_Str *lhs, EncList_Str *rhs);
+
+/* Sort keys */
+EncKey_Str *encKey_Str__allocNumeric();
+EncKey_Str *encKey_Str__allocFold();
+EncKey_Str *encKey_Str__allocField(char sep, int field, EncKey_Str *then);
+EncKey_Str *encKey_Str__allocCustom(EncKey_Str_Fn fn, void *arg);
+void encKey_Str__free(EncKey_Str *key);
+
+void encList_Str__sortBy(EncList_Str *obj, EncKey_Str *key);
+void encList_Str__mergeBy(EncList_Str *lhs, EncList_Str *rhs, EncKey_Str *key);
+char *encList_Str__getMinBy(EncList_Str *obj, EncKey_Str *key);
+char *encList_Str__getMaxBy(EncList_Str *obj, EncKey_Str *key);
+
+/* Finger index */
+void encList_Str__setIndex(EncList_Str *obj, int spacing);
+
+/* Interning */
+EncIntern_Str *encIntern_Str__alloc();
+void encIntern_Str__free(EncIntern_Str *intern);
+int encIntern_Str__count(EncIntern_Str *intern);
+void encList_Str__setIntern(EncList_Str *obj, EncIntern_Str *intern);
+
+/* Concurrent stack and queue */
+EncStack_Str *encStack_Str__alloc();
+void encStack_Str__free(EncStack_Str *obj);
+void encStack_Str__pushHead(EncStack_Str *obj, char *string, int dup);
+EncNode_Str *encStack_Str__popHead(EncStack_Str *obj);
+int encStack_Str__drain(EncStack_Str *obj, EncList_Str *list);
+
+EncQueue_Str *encQueue_Str__alloc();
+void encQueue_Str__free(EncQueue_Str *obj);
+void encQueue_Str__addTail(EncQueue_Str *obj, char *string, int dup);
+EncNode_Str *encQueue_Str__popHead(EncQueue_Str *obj);
+int encQueue_Str__drain(EncQueue_Str *obj, EncList_Str *list);
+
+/* Instrumentation (see listStats.h) */
+void encList_Str__getStats(ListStats *stats);
+void encList_Str__resetStats();
+void encList_Str__setTrace(ListStats_Trace hook);
+
+#endif
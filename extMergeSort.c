@@ -0,0 +1,359 @@
+/*
+ * extMergeSort.c
+ * Author:Qiwei Li
+ *
+ * External (out-of-core) sort for text files which are too big to hold in
+ * memory all at once.  Each line of the input is one string; the sorted
+ * lines are written to stdout, exactly as they would be by sorting the whole
+ * file in a single EncList_Str.
+ *
+ * USAGE:
+ *   extMergeSort [-r] [-u] [-m megabytes] [-T tmpdir] [inputFile]
+ *
+ *   -r   sort each piece with encList_Str__sortRadix(), instead of
+ *        encList_Str__sort() (the output is the same)
+ *   -u   write only the first of each run of equal lines, like sort -u
+ *   -m   memory budget, in megabytes (default 256)
+ *   -T   directory for the temporary run files (default $TMPDIR, or /tmp)
+ *
+ * The input is read in pieces which fit in the memory budget.  Each piece is
+ * sorted in memory, and written to a temporary "run" file.
+ * The runs are then merged, a line at a time, through a heap; each run gets
+ * an equal share of the budget for its read buffer.  If there are too many
+ * runs to merge at once, groups of them are first merged into longer runs.
+ *
+ * The sort is stable: runs are numbered in input order, and equal lines
+ * always come from the lowest-numbered run first.
+ *
+ * With -u, each piece is passed through encList_Str__unique() after it is
+ * sorted, so the run files only hold distinct lines; the merge then drops
+ * the lines which are equal to the last one it wrote.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+
+/* Rough cost of one line in memory, on top of its bytes: one list node */
+#define LINE_OVERHEAD	64
+
+/* Most runs that are merged in one pass (each one holds an open file) */
+#define MAX_FANIN	64
+
+/* Smallest read buffer that a run is given during the merge */
+#define MIN_BUFFER	(64 * 1024)
+
+typedef struct Run Run;
+struct Run {
+	FILE	*fp;
+	char	*line;		/* current line, without its newline */
+	size_t	cap;		/* size of the 'line' buffer */
+	char	*buf;		/* stdio buffer for 'fp' */
+};
+
+static size_t	budget = 256 * 1024 * 1024;
+static char	*tmpdir;
+static void	(*sortPiece)(EncList_Str *) = encList_Str__sort;
+static int	uniq;
+
+
+/* Opens a new, anonymous temporary file (it is unlinked right away, so it
+ * disappears as soon as it is closed).  Exits on error.
+ */
+static FILE *openTemp()
+{
+	char *path;
+	FILE *fp;
+	int fd;
+
+	path = (char *)malloc(strlen(tmpdir) + sizeof("/extMergeSort.XXXXXX"));
+	if (!path) {
+		perror("malloc");
+		exit(1);
+	}
+	sprintf(path, "%s/extMergeSort.XXXXXX", tmpdir);
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		perror(path);
+		exit(1);
+	}
+	unlink(path);
+	free(path);
+
+	fp = fdopen(fd, "w+");
+	if (!fp) {
+		perror("fdopen");
+		exit(1);
+	}
+	return fp;
+}
+
+/* Writes every string of the list, one per line.  Exits on error. */
+static void writeList(EncList_Str *list, FILE *out)
+{
+	EncNode_Str *node;
+
+	for (node = encList_Str__getHead(list); node; node = encNode_Str__getNext(node)) {
+		fwrite(encNode_Str__getStr(node), 1, encNode_Str__getLen(node), out);
+		putc('\n', out);
+	}
+	if (ferror(out)) {
+		perror("write");
+		exit(1);
+	}
+}
+
+/* Reads the next line of a run into run->line.  Returns 0 at end of file. */
+static int readRun(Run *run)
+{
+	ssize_t len;
+
+	len = getline(&run->line, &run->cap, run->fp);
+	if (len < 0)
+		return 0;
+
+	if (len > 0 && run->line[len - 1] == '\n')
+		run->line[len - 1] = '\0';
+	return 1;
+}
+
+/* Heap order: by line, and then by run number (which keeps the sort stable) */
+static int runLess(Run *runs, int a, int b)
+{
+	int cmp = strcmp(runs[a].line, runs[b].line);
+
+	return cmp < 0 || (cmp == 0 && a < b);
+}
+
+static void siftDown(Run *runs, int *heap, int n, int i)
+{
+	int child, tmp;
+
+	while ((child = 2 * i + 1) < n) {
+		if (child + 1 < n && runLess(runs, heap[child + 1], heap[child]))
+			child++;
+		if (!runLess(runs, heap[child], heap[i]))
+			break;
+
+		tmp = heap[i];
+		heap[i] = heap[child];
+		heap[child] = tmp;
+		i = child;
+	}
+}
+
+/* Merges runs [0, n) into 'out', and closes them.  The budget is shared out
+ * between the read buffers of the runs.
+ */
+static void mergeRuns(FILE **files, int n, FILE *out)
+{
+	Run *runs;
+	int *heap, live = 0, i;
+	size_t bufSize, len, lastCap = 0;
+	char *last = NULL;		/* copy of the last line written (for -u) */
+
+	runs = (Run *)calloc(n, sizeof(Run));
+	heap = (int *)malloc(sizeof(int) * n);
+	if (!runs || !heap) {
+		perror("malloc");
+		exit(1);
+	}
+
+	bufSize = budget / (n + 1);
+	if (bufSize < MIN_BUFFER)
+		bufSize = MIN_BUFFER;
+
+	for (i = 0; i < n; i++) {
+		runs[i].fp = files[i];
+		rewind(runs[i].fp);
+
+		runs[i].buf = (char *)malloc(bufSize);
+		if (!runs[i].buf) {
+			perror("malloc");
+			exit(1);
+		}
+		setvbuf(runs[i].fp, runs[i].buf, _IOFBF, bufSize);
+
+		if (readRun(&runs[i]))
+			heap[live++] = i;
+	}
+	for (i = live / 2 - 1; i >= 0; i--)
+		siftDown(runs, heap, live, i);
+
+	while (live) {
+		Run *run = &runs[heap[0]];
+
+		/* With -u, a line equal to the last one written is skipped */
+		if (!uniq || !last || strcmp(last, run->line)) {
+			fputs(run->line, out);
+			putc('\n', out);
+
+			if (uniq) {
+				len = strlen(run->line) + 1;
+				if (len > lastCap) {
+					lastCap = len * 2;
+					last = (char *)realloc(last, lastCap);
+					if (!last) {
+						perror("realloc");
+						exit(1);
+					}
+				}
+				memcpy(last, run->line, len);
+			}
+		}
+
+		if (!readRun(run))
+			heap[0] = heap[--live];
+		siftDown(runs, heap, live, 0);
+	}
+	if (ferror(out)) {
+		perror("write");
+		exit(1);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (ferror(runs[i].fp)) {
+			perror("read");
+			exit(1);
+		}
+		fclose(runs[i].fp);
+		free(runs[i].buf);
+		free(runs[i].line);
+	}
+	free(runs);
+	free(heap);
+	free(last);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin, **files = NULL;
+	EncPool_Str *pool = NULL;
+	EncList_Str *list = NULL;
+	char *line = NULL;
+	size_t cap = 0, used = 0;
+	ssize_t len;
+	int nfiles = 0, capFiles = 0, opt, i;
+
+	tmpdir = getenv("TMPDIR");
+	if (!tmpdir || !*tmpdir)
+		tmpdir = "/tmp";
+
+	while ((opt = getopt(argc, argv, "rum:T:")) != -1) {
+		switch (opt) {
+		case 'r':
+			sortPiece = encList_Str__sortRadix;
+			break;
+		case 'u':
+			uniq = 1;
+			break;
+		case 'm':
+			budget = (size_t)atol(optarg) * 1024 * 1024;
+			break;
+		case 'T':
+			tmpdir = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-r] [-u] [-m megabytes] [-T tmpdir] [inputFile]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (budget < MIN_BUFFER * 4)
+		budget = MIN_BUFFER * 4;
+
+	if (optind < argc) {
+		in = fopen(argv[optind], "r");
+		if (!in) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+
+	/* Phase 1: read as much as fits in the budget, sort it, and spill it */
+	for (;;) {
+		if (!list) {
+			pool = encPool_Str__alloc();
+			list = pool ? encList_Str__allocPool(pool) : NULL;
+			if (!list)
+				return 1;
+		}
+
+		len = getline(&line, &cap, in);
+		if (len >= 0) {
+			if (len > 0 && line[len - 1] == '\n')
+				line[--len] = '\0';
+			encList_Str__addTail(list, line, 1);
+			used += len + 1 + LINE_OVERHEAD;
+			if (used < budget)
+				continue;
+		}
+
+		sortPiece(list);
+		if (uniq)
+			encList_Str__unique(list);
+
+		/* Everything fit in memory: no need for any run files */
+		if (len < 0 && !nfiles) {
+			writeList(list, stdout);
+			break;
+		}
+
+		if (encList_Str__count(list)) {
+			if (nfiles == capFiles) {
+				capFiles = capFiles ? capFiles * 2 : 16;
+				files = (FILE **)realloc(files, sizeof(FILE *) * capFiles);
+				if (!files) {
+					perror("realloc");
+					return 1;
+				}
+			}
+			files[nfiles] = openTemp();
+			writeList(list, files[nfiles]);
+			nfiles++;
+		}
+
+		/* Releases every node and string of the piece at once */
+		encPool_Str__free(pool);
+		list = NULL;
+		used = 0;
+
+		if (len < 0)
+			break;
+	}
+	if (ferror(in)) {
+		perror("read");
+		return 1;
+	}
+	free(line);
+	if (list)
+		encPool_Str__free(pool);
+
+	/* Phase 2: merge groups of runs into longer runs, until there are few
+	 * enough to merge straight to the output.  Groups are consecutive, and
+	 * stay in order, so the sort stays stable.
+	 */
+	while (nfiles > MAX_FANIN) {
+		int out = 0;
+
+		for (i = 0; i < nfiles; i += MAX_FANIN) {
+			int n = nfiles - i < MAX_FANIN ? nfiles - i : MAX_FANIN;
+			FILE *merged = openTemp();
+
+			mergeRuns(files + i, n, merged);
+			files[out++] = merged;
+		}
+		nfiles = out;
+	}
+	if (nfiles)
+		mergeRuns(files, nfiles, stdout);
+
+	free(files);
+	if (in != stdin)
+		fclose(in);
+	return 0;
+}
@@ -0,0 +1,928 @@
+/*
+ * listBench.c
+ * Author:Qiwei Li
+ *
+ * Micro-benchmarks for the list classes.  Each benchmark is run on lists of
+ * 10^3, 10^4, ... elements (up to the -n limit), built from random, sorted
+ * and reverse-sorted data, and the results are printed as CSV or JSON: one
+ * record per (benchmark, pattern, size), with the time per operation, the
+ * throughput, and the resident set size of the process at the end of the
+ * timed part (while the list is still alive).
+ *
+ * USAGE:
+ *   listBench [-f csv|json] [-n maxSize] [-r repeats] [-b name,...]
+ *             [-p pattern,...] [-t threads,...] [-c]
+ *
+ *   -f   output format (default csv)
+ *   -n   largest list size (default 1000000; use 10000000 for the full run)
+ *   -r   times to run each benchmark; the fastest run is reported (default 3)
+ *   -b   only run the benchmarks whose names start with one of these
+ *   -p   only use these data patterns (random, sorted, reverse)
+ *   -t   thread counts for the parallel benchmarks (default 1, 2, 4, ... up
+ *        to the number of CPUs, and that number itself); each one is
+ *        reported as its own benchmark, with "_t<threads>" on its name
+ *   -c   also count the cache misses in the timed part (with the hardware
+ *        counters, through perf_event_open()), and report them per op
+ *
+ * The data is generated from a fixed seed, so runs are repeatable.  Only the
+ * operation being measured is timed; building the input lists and freeing
+ * them afterward are not (except for the alloc_free benchmarks).
+ *
+ * 'make bench-misses' runs the comparison-heavy benchmarks with -c twice:
+ * once as usual, and once built with -DENCLIST_STR_NO_PREFIX, which makes
+ * the string lists ignore the key prefixes cached in their nodes - so the
+ * two runs show how many misses the prefixes save.  -c needs access to the
+ * counters (see /proc/sys/kernel/perf_event_paranoid); where there is none,
+ * 'perf stat -e cache-misses ./listBench -b str_sort -p random' gives the
+ * same numbers for a whole run (setup included).
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+#define ENCLIST_STR_INTERNAL	/* for the inline cursor methods */
+#include "encapsulatedListStrCursor.h"
+#include "encUnrolledListStr.h"
+#include "dblListInt.h"
+#include "dblListIntExt.h"
+#include "dblArrInt.h"
+
+#define STR_LEN		16	/* length of each generated string */
+#define QUERIES		1000	/* index() calls per run */
+#define SPLITS		100	/* splitAt() calls per run */
+#define FINGER_SPACING	64
+#define SCAN_BATCH	64	/* strings per cursorNextN() call */
+#define MAX_THREAD_COUNTS	16	/* -t values */
+
+enum { RANDOM, SORTED, REVERSE, NPATTERNS };
+static const char *patternNames[NPATTERNS] = { "random", "sorted", "reverse" };
+
+typedef struct Data Data;
+struct Data {
+	int	n;
+	int	pattern;
+	char	**strs;
+	char	*buf;
+	int	*ints;
+	int	*queries;	/* QUERIES random positions in [0, n) */
+};
+
+typedef struct Bench Bench;
+struct Bench {
+	const char	*name;
+	int		maxN;		/* skip larger sizes (0: no limit) */
+	int		threaded;	/* run once per -t thread count */
+	long		(*run)(Data *d, double *ns);	/* returns ops */
+};
+
+static long rssKb;	/* sampled by each benchmark, at the end of its timed part */
+static int missFd = -1;	/* cache miss counter (-c), or -1 */
+static long long missMark, misses;	/* see now() */
+static int nthreads;	/* for the threaded benchmark being run */
+static volatile long long sink;	/* keeps computed results from being optimized away */
+static unsigned long long rngState = 88172645463325252ULL;
+
+
+static unsigned int rng()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 7;
+	rngState ^= rngState << 17;
+	return (unsigned int)(rngState >> 16);
+}
+
+/* Every benchmark calls now() exactly twice: at the start and at the end of
+ * its timed part.  So with -c, reading the miss counter here leaves the
+ * misses of the timed part in 'misses' afterward.
+ */
+static double now()
+{
+	struct timespec ts;
+	long long count;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	if (missFd >= 0 && read(missFd, &count, sizeof(count)) == sizeof(count)) {
+		misses = count - missMark;
+		missMark = count;
+	}
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Opens the cache miss counter for this thread and the threads it starts
+ * from now on (sortParallel()'s workers); returns -1 if that fails
+ */
+static int openMissCounter()
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	missFd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	if (missFd < 0)
+		fprintf(stderr, "perf_event_open: %s (are there hardware counters, and may "
+		        "this user read them?)\n", strerror(errno));
+	return missFd;
+}
+
+static void sampleRss()
+{
+	long pages = 0, resident = 0;
+	FILE *fp;
+
+	fp = fopen("/proc/self/statm", "r");
+	if (fp) {
+		if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+			resident = 0;
+		fclose(fp);
+	}
+	rssKb = resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int cmpStr(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+static int cmpInt(const void *a, const void *b)
+{
+	int x = *(const int *)a, y = *(const int *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Generates n strings and ints, in the given order */
+static void makeData(Data *d, int n, int pattern)
+{
+	int i, j;
+
+	d->n = n;
+	d->pattern = pattern;
+	d->buf = (char *)malloc((size_t)n * (STR_LEN + 1));
+	d->strs = (char **)malloc(sizeof(char *) * n);
+	d->ints = (int *)malloc(sizeof(int) * n);
+	d->queries = (int *)malloc(sizeof(int) * QUERIES);
+	if (!d->buf || !d->strs || !d->ints || !d->queries) {
+		perror("malloc");
+		exit(1);
+	}
+
+	for (i = 0; i < n; i++) {
+		d->strs[i] = d->buf + (size_t)i * (STR_LEN + 1);
+		for (j = 0; j < STR_LEN; j++)
+			d->strs[i][j] = 'a' + rng() % 26;
+		d->strs[i][STR_LEN] = '\0';
+		d->ints[i] = (int)(rng() ^ 0x80000000u);
+	}
+	for (i = 0; i < QUERIES; i++)
+		d->queries[i] = rng() % n;
+
+	if (pattern != RANDOM) {
+		qsort(d->strs, n, sizeof(char *), cmpStr);
+		qsort(d->ints, n, sizeof(int), cmpInt);
+	}
+	if (pattern == REVERSE) {
+		for (i = 0; i < n / 2; i++) {
+			char *s = d->strs[i];
+			int v = d->ints[i];
+
+			d->strs[i] = d->strs[n - 1 - i];
+			d->strs[n - 1 - i] = s;
+			d->ints[i] = d->ints[n - 1 - i];
+			d->ints[n - 1 - i] = v;
+		}
+	}
+}
+
+static void freeData(Data *d)
+{
+	free(d->buf);
+	free(d->strs);
+	free(d->ints);
+	free(d->queries);
+}
+
+static EncList_Str *buildStr(Data *d, int from, int to)
+{
+	EncList_Str *list = encList_Str__alloc();
+	int i;
+
+	for (i = from; i < to; i++)
+		encList_Str__addTail(list, d->strs[i], 1);
+	return list;
+}
+
+static DblList_Int *buildInt(Data *d)
+{
+	DblList_Int *head = dblList_Int__alloc(d->ints[0]);
+
+	dblList_Int__addTailN(head, d->ints + 1, d->n - 1);
+	return head;
+}
+
+static void freeInt(DblList_Int *node)
+{
+	DblList_Int *next;
+
+	for (; node; node = next) {
+		next = dblList_Int__getNext(node);
+		if (next)
+			dblList_Int__remove(node);
+		dblList_Int__free(node);
+	}
+}
+
+
+/* ---- EncList_Str ---- */
+
+static long benchStrAllocFree(Data *d, double *ns)
+{
+	double t = now();
+	EncList_Str *list = buildStr(d, 0, d->n);
+
+	sampleRss();
+	encList_Str__free(list);
+	*ns = now() - t;
+	return d->n;
+}
+static long benchStrAllocFreePool(Data *d, double *ns)
+{
+	double t = now();
+	EncPool_Str *pool = encPool_Str__alloc();
+	EncList_Str *list = encList_Str__allocPool(pool);
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		encList_Str__addTail(list, d->strs[i], 1);
+	sampleRss();
+	encPool_Str__free(pool);
+	*ns = now() - t;
+	return d->n;
+}
+static long benchStrAddTail(Data *d, double *ns)
+{
+	EncList_Str *list = encList_Str__alloc();
+	double t = now();
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		encList_Str__addTail(list, d->strs[i], 1);
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	return d->n;
+}
+static long benchStrAddTailN(Data *d, double *ns)
+{
+	EncList_Str *list = encList_Str__alloc();
+	double t = now();
+
+	encList_Str__addTailN(list, d->strs, d->n, 1);
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	return d->n;
+}
+
+static long strIndex(Data *d, double *ns, int spacing)
+{
+	EncList_Str *list = buildStr(d, 0, d->n);
+	double t;
+	int i;
+
+	if (spacing) {
+		encList_Str__setIndex(list, spacing);
+		encList_Str__index(list, 0);	/* builds the index */
+	}
+
+	t = now();
+	for (i = 0; i < QUERIES; i++)
+		encList_Str__index(list, d->queries[i]);
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	return QUERIES;
+}
+static long benchStrIndex(Data *d, double *ns)
+{
+	return strIndex(d, ns, 0);
+}
+static long benchStrIndexFinger(Data *d, double *ns)
+{
+	return strIndex(d, ns, FINGER_SPACING);
+}
+
+static long benchStrSplitAt(Data *d, double *ns)
+{
+	EncList_Str *list = buildStr(d, 0, d->n), *tail;
+	double t = now();
+	int i;
+
+	/* Split, and glue the pieces back together */
+	for (i = 0; i < SPLITS; i++) {
+		tail = encList_Str__splitAt(list, d->queries[i]);
+		encList_Str__append(list, tail);
+		encList_Str__free(tail);
+	}
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	return SPLITS;
+}
+
+static long benchStrMerge(Data *d, double *ns)
+{
+	EncList_Str *lhs = buildStr(d, 0, d->n / 2), *rhs = buildStr(d, d->n / 2, d->n);
+	double t;
+
+	encList_Str__sort(lhs);
+	encList_Str__sort(rhs);
+
+	t = now();
+	encList_Str__merge(lhs, rhs);
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(lhs);
+	encList_Str__free(rhs);
+	return d->n;
+}
+
+static long strSort(Data *d, double *ns, int which)
+{
+	EncList_Str *list = buildStr(d, 0, d->n);
+	double t = now();
+
+	switch (which) {
+	case 0: encList_Str__sort(list); break;
+	case 1: encList_Str__sortNatural(list); break;
+	case 2: encList_Str__sortRadix(list); break;
+	case 3: encList_Str__sortParallel(list, nthreads); break;
+	}
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	return d->n;
+}
+static long benchStrSort(Data *d, double *ns)
+{
+	return strSort(d, ns, 0);
+}
+static long benchStrSortNatural(Data *d, double *ns)
+{
+	return strSort(d, ns, 1);
+}
+static long benchStrSortRadix(Data *d, double *ns)
+{
+	return strSort(d, ns, 2);
+}
+static long benchStrSortParallel(Data *d, double *ns)
+{
+	return strSort(d, ns, 3);
+}
+
+static long strMinMax(Data *d, double *ns, int max)
+{
+	EncList_Str *list = buildStr(d, 0, d->n);
+	double t = now();
+
+	if (max)
+		encList_Str__getMax(list);
+	else
+		encList_Str__getMin(list);
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	return d->n;
+}
+static long benchStrGetMin(Data *d, double *ns)
+{
+	return strMinMax(d, ns, 0);
+}
+static long benchStrGetMax(Data *d, double *ns)
+{
+	return strMinMax(d, ns, 1);
+}
+
+/* The scans walk a sorted list of strings which are not copied (dup=0),
+ * like one from mapFile(): so after the sort (which is not timed), both the
+ * nodes and the strings are scattered in memory, in random order - unless
+ * the data was sorted to begin with.  Each scan adds up the first byte of
+ * every string; str_count instead counts the strings below the one in the
+ * middle of the data, which compares (most of) each string.
+ */
+static long strScan(Data *d, double *ns, int how)
+{
+	EncList_Str *list = encList_Str__alloc();
+	EncList_Str_Cursor cur;
+	EncNode_Str *node;
+	char *strs[SCAN_BATCH], *str, *pivot = d->strs[d->n / 2];
+	long long sum = 0;
+	double t;
+	int i, got;
+
+	for (i = 0; i < d->n; i++)
+		encList_Str__addTail(list, d->strs[i], 0);
+	encList_Str__sortRadix(list);
+
+	t = now();
+	switch (how) {
+	case 0:
+		for (node = encList_Str__getHead(list); node; node = encNode_Str__getNext(node))
+			sum += encNode_Str__getStr(node)[0];
+		break;
+	case 1:
+		encList_Str__cursor(list, &cur);
+		while ((str = encList_Str__cursorNext(&cur)))
+			sum += str[0];
+		break;
+	case 2:
+		encList_Str__cursor(list, &cur);
+		while ((got = encList_Str__cursorNextN(&cur, strs, SCAN_BATCH)))
+			for (i = 0; i < got; i++)
+				sum += strs[i][0];
+		break;
+	case 3:
+		encList_Str__cursor(list, &cur);
+		while ((got = encList_Str__cursorNextNFast(&cur, strs, SCAN_BATCH)))
+			for (i = 0; i < got; i++)
+				sum += strs[i][0];
+		break;
+	case 4:
+		for (node = encList_Str__getHead(list); node; node = encNode_Str__getNext(node))
+			sum += strcmp(encNode_Str__getStr(node), pivot) < 0;
+		break;
+	}
+	*ns = now() - t;
+	sampleRss();
+	encList_Str__free(list);
+	sink = sum;
+	return d->n;
+}
+static long benchStrScanGetNext(Data *d, double *ns)
+{
+	return strScan(d, ns, 0);
+}
+static long benchStrScanCursor(Data *d, double *ns)
+{
+	return strScan(d, ns, 1);
+}
+static long benchStrScanCursorN(Data *d, double *ns)
+{
+	return strScan(d, ns, 2);
+}
+static long benchStrScanCursorNFast(Data *d, double *ns)
+{
+	return strScan(d, ns, 3);
+}
+static long benchStrCount(Data *d, double *ns)
+{
+	return strScan(d, ns, 4);
+}
+
+/* ---- EncUList_Str (unrolled) ---- */
+
+/* The same as str_addTail; compare their rss_kb, too */
+static long benchUListAddTail(Data *d, double *ns)
+{
+	EncUList_Str *list = encUList_Str__alloc();
+	double t = now();
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		encUList_Str__addTail(list, d->strs[i], 1);
+	*ns = now() - t;
+	sampleRss();
+	encUList_Str__free(list);
+	return d->n;
+}
+
+static long benchUListGetMin(Data *d, double *ns)
+{
+	EncUList_Str *list = encUList_Str__alloc();
+	double t;
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		encUList_Str__addTail(list, d->strs[i], 1);
+
+	t = now();
+	encUList_Str__getMin(list);
+	*ns = now() - t;
+	sampleRss();
+	encUList_Str__free(list);
+	return d->n;
+}
+
+/* The same as str_scan_getNext and str_count, with an iterator */
+static long ulistScan(Data *d, double *ns, int count)
+{
+	EncUList_Str *list = encUList_Str__alloc();
+	EncUList_Str_Iter it;
+	char *str, *pivot = d->strs[d->n / 2];
+	long long sum = 0;
+	double t;
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		encUList_Str__addTail(list, d->strs[i], 0);
+	encUList_Str__sort(list);
+
+	t = now();
+	encUList_Str__iter(list, &it);
+	if (count) {
+		while ((str = encUList_Str__iterNext(&it)))
+			sum += strcmp(str, pivot) < 0;
+	} else {
+		while ((str = encUList_Str__iterNext(&it)))
+			sum += str[0];
+	}
+	*ns = now() - t;
+	sampleRss();
+	encUList_Str__free(list);
+	sink = sum;
+	return d->n;
+}
+static long benchUListScan(Data *d, double *ns)
+{
+	return ulistScan(d, ns, 0);
+}
+static long benchUListCount(Data *d, double *ns)
+{
+	return ulistScan(d, ns, 1);
+}
+
+/* ---- DblList_Int ---- */
+
+static long benchIntAllocFree(Data *d, double *ns)
+{
+	double t = now();
+	DblList_Int *head, *tail, *node;
+	int i;
+
+	head = tail = dblList_Int__alloc(d->ints[0]);
+	for (i = 1; i < d->n; i++) {
+		node = dblList_Int__alloc(d->ints[i]);
+		dblList_Int__addAfter(tail, node);
+		tail = node;
+	}
+	sampleRss();
+	freeInt(head);
+	*ns = now() - t;
+	return d->n;
+}
+static long benchIntAllocFreePool(Data *d, double *ns)
+{
+	double t = now();
+	DblPool_Int *pool = dblPool_Int__alloc();
+	DblList_Int *tail, *node;
+	int i;
+
+	tail = dblPool_Int__allocNode(pool, d->ints[0]);
+	for (i = 1; i < d->n; i++) {
+		node = dblPool_Int__allocNode(pool, d->ints[i]);
+		dblList_Int__addAfter(tail, node);
+		tail = node;
+	}
+	sampleRss();
+	dblPool_Int__free(pool);
+	*ns = now() - t;
+	return d->n;
+}
+static long benchIntAddTail(Data *d, double *ns)
+{
+	DblList_Int *head = dblList_Int__alloc(d->ints[0]);
+	double t = now();
+	int i;
+
+	for (i = 1; i < d->n; i++)
+		dblList_Int__addTail(head, d->ints[i]);
+	*ns = now() - t;
+	sampleRss();
+	freeInt(head);
+	return d->n - 1;
+}
+static long benchIntAddTailN(Data *d, double *ns)
+{
+	DblList_Int *head = dblList_Int__alloc(d->ints[0]);
+	double t = now();
+
+	dblList_Int__addTailN(head, d->ints + 1, d->n - 1);
+	*ns = now() - t;
+	sampleRss();
+	freeInt(head);
+	return d->n - 1;
+}
+static long benchIntPushTail(Data *d, double *ns)
+{
+	DblListHdr_Int *hdr = dblListHdr_Int__alloc();
+	double t = now();
+	int i;
+
+	for (i = 0; i < d->n; i++)
+		dblListHdr_Int__pushTail(hdr, d->ints[i]);
+	*ns = now() - t;
+	sampleRss();
+	dblListHdr_Int__free(hdr);
+	return d->n;
+}
+static long benchIntSwapWithNext(Data *d, double *ns)
+{
+	DblList_Int *head = buildInt(d), *node = head;
+	double t = now();
+
+	/* Bubbles the head node all the way to the tail */
+	while (dblList_Int__getNext(node))
+		dblList_Int__swapWithNext(node);
+	*ns = now() - t;
+	sampleRss();
+	freeInt(dblList_Int__getHead(node));
+	return d->n - 1;
+}
+
+static long benchIntGetMinWalk(Data *d, double *ns)
+{
+	DblList_Int *head = buildInt(d), *node;
+	double t = now();
+	int min = dblList_Int__getVal(head);
+
+	for (node = head; node; node = dblList_Int__getNext(node)) {
+		if (dblList_Int__getVal(node) < min)
+			min = dblList_Int__getVal(node);
+	}
+	*ns = now() - t;
+	sampleRss();
+	freeInt(head);
+	sink = min;
+	return d->n;
+}
+static long benchIntGetMin(Data *d, double *ns)
+{
+	DblList_Int *head = buildInt(d);
+	double t = now();
+
+	sink = dblList_Int__getMin(head);
+	*ns = now() - t;
+	sampleRss();
+	freeInt(head);
+	return d->n;
+}
+static long benchIntGetMax(Data *d, double *ns)
+{
+	DblList_Int *head = buildInt(d);
+	double t = now();
+
+	sink = dblList_Int__getMax(head);
+	*ns = now() - t;
+	sampleRss();
+	freeInt(head);
+	return d->n;
+}
+
+/* ---- DblArr_Int (array-backed) ---- */
+
+static long arrScan(Data *d, double *ns, int compact)
+{
+	DblArr_Int *arr = dblArr_Int__alloc(0);
+	uint32_t head, tail, node;
+	long long sum = 0;
+	double t;
+	int i;
+
+	head = tail = dblArr_Int__allocNode(arr, d->ints[0]);
+	for (i = 1; i < d->n; i++) {
+		node = dblArr_Int__allocNode(arr, d->ints[i]);
+		dblArr_Int__addAfter(arr, tail, node);
+		tail = node;
+	}
+	if (compact)
+		head = dblArr_Int__compact(arr, head);
+
+	t = now();
+	if (compact) {
+		for (i = 0; i < d->n; i++)
+			sum += arr->val[i];
+	} else {
+		for (node = head; node != DBLARR_INT_NIL; node = arr->next[node])
+			sum += arr->val[node];
+	}
+	*ns = now() - t;
+	sampleRss();
+	dblArr_Int__free(arr);
+	sink = sum;
+	return d->n;
+}
+static long benchArrScanWalk(Data *d, double *ns)
+{
+	return arrScan(d, ns, 0);
+}
+static long benchArrScanCompact(Data *d, double *ns)
+{
+	return arrScan(d, ns, 1);
+}
+
+
+static Bench benches[] = {
+	{ "str_alloc_free",		0,	0,	benchStrAllocFree },
+	{ "str_alloc_free_pool",	0,	0,	benchStrAllocFreePool },
+	{ "str_addTail",		0,	0,	benchStrAddTail },
+	{ "str_addTailN",		0,	0,	benchStrAddTailN },
+	{ "str_index",			0,	0,	benchStrIndex },
+	{ "str_index_finger",		0,	0,	benchStrIndexFinger },
+	{ "str_splitAt",		0,	0,	benchStrSplitAt },
+	{ "str_merge",			0,	0,	benchStrMerge },
+	{ "str_sort",			0,	0,	benchStrSort },
+	{ "str_sortNatural",		0,	0,	benchStrSortNatural },
+	{ "str_sortRadix",		0,	0,	benchStrSortRadix },
+	{ "str_sortParallel",		0,	1,	benchStrSortParallel },
+	{ "str_getMin",			0,	0,	benchStrGetMin },
+	{ "str_getMax",			0,	0,	benchStrGetMax },
+	{ "str_scan_getNext",		0,	0,	benchStrScanGetNext },
+	{ "str_scan_cursor",		0,	0,	benchStrScanCursor },
+	{ "str_scan_cursorN",		0,	0,	benchStrScanCursorN },
+	{ "str_scan_cursorN_fast",	0,	0,	benchStrScanCursorNFast },
+	{ "str_count",			0,	0,	benchStrCount },
+	{ "ulist_addTail",		0,	0,	benchUListAddTail },
+	{ "ulist_getMin",		0,	0,	benchUListGetMin },
+	{ "ulist_scan",			0,	0,	benchUListScan },
+	{ "ulist_count",		0,	0,	benchUListCount },
+	{ "int_alloc_free",		0,	0,	benchIntAllocFree },
+	{ "int_alloc_free_pool",	0,	0,	benchIntAllocFreePool },
+	{ "int_addTail",		10000,	0,	benchIntAddTail },	/* O(N^2) */
+	{ "int_addTailN",		0,	0,	benchIntAddTailN },
+	{ "int_pushTail",		0,	0,	benchIntPushTail },
+	{ "int_swapWithNext",		0,	0,	benchIntSwapWithNext },
+	{ "int_getMin_walk",		0,	0,	benchIntGetMinWalk },
+	{ "int_getMin",			0,	0,	benchIntGetMin },
+	{ "int_getMax",			0,	0,	benchIntGetMax },
+	{ "arr_scan_walk",		0,	0,	benchArrScanWalk },
+	{ "arr_scan_compact",		0,	0,	benchArrScanCompact },
+};
+#define NBENCHES	((int)(sizeof(benches) / sizeof(benches[0])))
+
+/* Returns nonzero if 'name' starts with one of the comma-separated prefixes
+ * (or if there is no list)
+ */
+static int selected(const char *list, const char *name)
+{
+	const char *p;
+	size_t len;
+
+	if (!list)
+		return 1;
+
+	for (p = list; *p; p += len + (p[len] == ',')) {
+		len = strcspn(p, ",");
+		if (len && !strncmp(name, p, len))
+			return 1;
+	}
+	return 0;
+}
+
+/* Runs one benchmark 'repeats' times, and prints the fastest run under the
+ * given name
+ */
+static void runBench(Bench *bench, const char *name, Data *d, int repeats, int json, int *first)
+{
+	double best = 0, ns;
+	long ops = 0, bestRss = 0;
+	long long bestMisses = 0;
+	int r;
+
+	for (r = 0; r < repeats; r++) {
+		ops = bench->run(d, &ns);
+		if (!r || ns < best) {
+			best = ns;
+			bestRss = rssKb;
+			bestMisses = misses;
+		}
+	}
+	if (best <= 0)
+		best = 1;
+
+	if (json)
+		printf("%s  {\"bench\": \"%s\", \"pattern\": \"%s\", \"n\": %d, \"ops\": %ld, "
+		       "\"ns_per_op\": %.3f, \"ops_per_sec\": %.0f, \"rss_kb\": %ld",
+		       *first ? "" : ",\n", name, patternNames[d->pattern], d->n,
+		       ops, best / ops, ops * 1e9 / best, bestRss);
+	else
+		printf("%s,%s,%d,%ld,%.3f,%.0f,%ld", name,
+		       patternNames[d->pattern], d->n, ops, best / ops, ops * 1e9 / best, bestRss);
+	if (missFd >= 0)
+		printf(json ? ", \"misses_per_op\": %.3f" : ",%.3f", (double)bestMisses / ops);
+	printf(json ? "}" : "\n");
+	*first = 0;
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	const char *benchList = NULL, *patternList = NULL, *threadList = NULL, *p;
+	int json = 0, maxN = 1000000, repeats = 3, first = 1, countMisses = 0;
+	int threads[MAX_THREAD_COUNTS], nthreadCounts = 0, ncpus;
+	int opt, n, pattern, b, t;
+	char name[64];
+
+	while ((opt = getopt(argc, argv, "f:n:r:b:p:t:c")) != -1) {
+		switch (opt) {
+		case 'f':
+			json = !strcmp(optarg, "json");
+			break;
+		case 'n':
+			maxN = atoi(optarg);
+			break;
+		case 'r':
+			repeats = atoi(optarg) > 0 ? atoi(optarg) : 1;
+			break;
+		case 'b':
+			benchList = optarg;
+			break;
+		case 'p':
+			patternList = optarg;
+			break;
+		case 't':
+			threadList = optarg;
+			break;
+		case 'c':
+			countMisses = 1;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-f csv|json] [-n maxSize] [-r repeats] "
+			        "[-b name,...] [-p pattern,...] [-t threads,...] [-c]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	/* The thread counts: as given, or doubling up to the number of CPUs */
+	if (threadList) {
+		for (p = threadList; *p && nthreadCounts < MAX_THREAD_COUNTS; p += strcspn(p, ",")) {
+			p += *p == ',';
+			if (atoi(p) > 0)
+				threads[nthreadCounts++] = atoi(p);
+		}
+	} else {
+		ncpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+		for (t = 1; t < ncpus && nthreadCounts < MAX_THREAD_COUNTS - 1; t *= 2)
+			threads[nthreadCounts++] = t;
+		threads[nthreadCounts++] = ncpus > 1 ? ncpus : 1;
+	}
+	if (!nthreadCounts) {
+		fprintf(stderr, "%s: -t needs at least one thread count\n", argv[0]);
+		return 1;
+	}
+
+	if (countMisses && openMissCounter() < 0)
+		return 1;
+
+	if (json)
+		printf("[\n");
+	else
+		printf("bench,pattern,n,ops,ns_per_op,ops_per_sec,rss_kb%s\n",
+		       countMisses ? ",misses_per_op" : "");
+
+	for (n = 1000; n <= maxN; n *= 10) {
+		for (pattern = 0; pattern < NPATTERNS; pattern++) {
+			Data d;
+
+			if (!selected(patternList, patternNames[pattern]))
+				continue;
+			makeData(&d, n, pattern);
+
+			for (b = 0; b < NBENCHES; b++) {
+				if (!selected(benchList, benches[b].name))
+					continue;
+				if (benches[b].maxN && n > benches[b].maxN)
+					continue;
+
+				if (!benches[b].threaded) {
+					runBench(&benches[b], benches[b].name, &d, repeats, json, &first);
+					continue;
+				}
+				for (t = 0; t < nthreadCounts; t++) {
+					nthreads = threads[t];
+					snprintf(name, sizeof(name), "%s_t%d", benches[b].name, nthreads);
+					runBench(&benches[b], name, &d, repeats, json, &first);
+				}
+			}
+
+			freeData(&d);
+		}
+		if (n > maxN / 10)
+			break;	/* n *= 10 would pass maxN (or overflow) */
+	}
+
+	if (json)
+		printf("\n]\n");
+	return 0;
+}
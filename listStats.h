@@ -0,0 +1,90 @@
+/*
+ * listStats.h
+ * Author:Qiwei Li
+ *
+ * Optional instrumentation counters for the list classes (EncList_Str and
+ * DblList_Int).  When a program is built with -DLIST_STATS, each class keeps
+ * count of the comparisons, walks, allocations and string copies that its
+ * methods do.  A snapshot of the counts can be taken at any time (see
+ * encList_Str__getStats() and dblList_Int__getStats()), and a trace hook can
+ * be installed, which is called at the end of each of the more expensive
+ * methods with the counts for that one call.
+ *
+ * Without -DLIST_STATS, every counter macro below expands to nothing, so the
+ * methods are exactly as fast as before; getStats() then always reports
+ * zeros, and the trace hook is never called.
+ *
+ * The counts are kept per thread, so that they cost no more than a plain
+ * increment: a snapshot only covers the methods called by the same thread.
+ * (Work that a method hands to other threads, like sortParallel(), is added
+ * to the calling thread's counts.)
+ */
+
+#ifndef __LISTSTATS_H__
+#define __LISTSTATS_H__
+
+typedef struct ListStats ListStats;
+struct ListStats {
+	unsigned long long	compares;	/* comparisons of two strings (or values) */
+	unsigned long long	strcmps;	/* ...that had to read the strings themselves */
+	unsigned long long	nodesWalked;	/* links followed to find a node or position */
+	unsigned long long	mallocs;	/* successful malloc()s (and calloc()s, etc.) */
+	unsigned long long	frees;
+	unsigned long long	bytesDup;	/* bytes copied by dup=1 (including the NULs) */
+};
+
+/* Trace hook: 'op' is the name of the method, and 'delta' holds the counts
+ * for that call alone (including any methods that it called).  Methods which
+ * are called from inside another instrumented method are not traced on
+ * their own.
+ */
+typedef void (*ListStats_Trace)(const char *op, const ListStats *delta);
+
+static inline void listStats__add(ListStats *to, const ListStats *from)
+{
+	to->compares += from->compares;
+	to->strcmps += from->strcmps;
+	to->nodesWalked += from->nodesWalked;
+	to->mallocs += from->mallocs;
+	to->frees += from->frees;
+	to->bytesDup += from->bytesDup;
+}
+
+/* Calls the hook with the counts since 'mark' */
+static inline void listStats__trace(ListStats_Trace hook, const char *op,
+                                    const ListStats *now, const ListStats *mark)
+{
+	ListStats delta;
+
+	delta.compares = now->compares - mark->compares;
+	delta.strcmps = now->strcmps - mark->strcmps;
+	delta.nodesWalked = now->nodesWalked - mark->nodesWalked;
+	delta.mallocs = now->mallocs - mark->mallocs;
+	delta.frees = now->frees - mark->frees;
+	delta.bytesDup = now->bytesDup - mark->bytesDup;
+	hook(op, &delta);
+}
+
+/* LIST_STATS_ADD() bumps one counter.  LIST_STATS_BEGIN() and LIST_STATS_END()
+ * go around the body of a traced method: BEGIN declares 'mark' (so it goes
+ * with the other declarations, or at least in the same block as END), and
+ * END must be reached on every path out of the method after BEGIN.  'depth'
+ * counts the traced methods in progress, so that only the outermost one
+ * calls the hook.
+ */
+#ifdef LIST_STATS
+#define LIST_STATS_ADD(stats, field, n)	((stats).field += (n))
+#define LIST_STATS_BEGIN(stats, depth, mark) \
+	ListStats mark = (stats); (depth)++
+#define LIST_STATS_END(stats, depth, mark, hook, op) \
+	do { \
+		if (!--(depth) && (hook)) \
+			listStats__trace((hook), (op), &(stats), &(mark)); \
+	} while (0)
+#else
+#define LIST_STATS_ADD(stats, field, n)			((void)0)
+#define LIST_STATS_BEGIN(stats, depth, mark)		((void)0)
+#define LIST_STATS_END(stats, depth, mark, hook, op)	((void)0)
+#endif
+
+#endif
@@ -0,0 +1,265 @@
+/*
+ * test_encList_01_invariants.c
+ * Author:Qiwei Li
+ *
+ * Stress test for EncList_Str.  Runs a long random sequence of addHead(),
+ * addTail(), popHead(), splitAt() and append(), the sorts, merge() and
+ * index() on a pair of lists, and after every step checks both lists
+ * against a plain array of the strings they should hold: the count, the
+ * head and the tail, the next/prev links in both directions, and the
+ * strings themselves.
+ *
+ * One of the lists comes from a pool, and both have finger indexes, so that
+ * those paths are covered too.  At the end, one more pooled list (with an
+ * index) is left for the pool to free, index and all; run the test under a
+ * leak checker to see that it does.  Some of the strings are short enough
+ * to be stored inline in the nodes, and the others are not.
+ *
+ * USAGE:
+ *   test_encList_01_invariants [seed [steps]]
+ *
+ * Prints "PASS" and exits with 0 if every check passes; otherwise, prints
+ * the first failure and exits with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+
+#define MAX_LEN		400	/* lists longer than this only shrink */
+#define VOCAB		64	/* distinct strings (so there are duplicates) */
+
+typedef struct Model Model;
+struct Model {
+	EncList_Str	*list;
+	char		**strs;
+	int		n;
+};
+
+static char vocab[VOCAB][48];
+static unsigned long long rngState;
+static long step;
+
+
+static unsigned int rng()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 7;
+	rngState ^= rngState << 17;
+	return (unsigned int)(rngState >> 16);
+}
+
+static void fail(const char *what, const char *why)
+{
+	printf("FAIL at step %ld (%s): %s\n", step, what, why);
+	exit(1);
+}
+
+static int cmpStr(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Checks every invariant of a list against its model */
+static void check(Model *m, const char *what)
+{
+	EncNode_Str *node, *prev = NULL;
+	int i = 0;
+
+	if (encList_Str__count(m->list) != m->n)
+		fail(what, "count() is wrong");
+
+	for (node = encList_Str__getHead(m->list); node; node = encNode_Str__getNext(node)) {
+		if (encNode_Str__getPrev(node) != prev)
+			fail(what, "a prev link is wrong");
+		if (i >= m->n)
+			fail(what, "the list is longer than count()");
+		if (strcmp(encNode_Str__getStr(node), m->strs[i]))
+			fail(what, "a string is wrong");
+		prev = node;
+		i++;
+	}
+	if (i != m->n)
+		fail(what, "the list is shorter than count()");
+	if (encList_Str__getTail(m->list) != prev)
+		fail(what, "getTail() is wrong");
+}
+
+/* Inserts 'str' into the model at position 'pos' */
+static void modelInsert(Model *m, int pos, char *str)
+{
+	memmove(m->strs + pos + 1, m->strs + pos, sizeof(char *) * (m->n - pos));
+	m->strs[pos] = str;
+	m->n++;
+}
+
+/* Moves all of src's model onto the end of dst's */
+static void modelAppend(Model *dst, Model *src)
+{
+	memcpy(dst->strs + dst->n, src->strs, sizeof(char *) * src->n);
+	dst->n += src->n;
+	src->n = 0;
+}
+
+static void sortList(Model *m)
+{
+	switch (rng() % 4) {
+	case 0: encList_Str__sort(m->list); break;
+	case 1: encList_Str__sortNatural(m->list); break;
+	case 2: encList_Str__sortRadix(m->list); break;
+	case 3: encList_Str__sortParallel(m->list, 2); break;
+	}
+	qsort(m->strs, m->n, sizeof(char *), cmpStr);
+}
+
+int main(int argc, char **argv)
+{
+	EncPool_Str *pool;
+	EncNode_Str *node;
+	EncList_Str *tail;
+	Model lists[2], *m, *other, split;
+	long steps;
+	int i, k, pos;
+
+	rngState = argc > 1 ? strtoull(argv[1], NULL, 0) : 88172645463325252ULL;
+	steps = argc > 2 ? atol(argv[2]) : 50000;
+	if (!rngState)
+		rngState = 1;
+
+	for (i = 0; i < VOCAB; i++) {
+		if (i % 2)
+			sprintf(vocab[i], "s%02d", i);
+		else
+			sprintf(vocab[i], "a longer string, which is not inline: %02d", i);
+	}
+
+	pool = encPool_Str__alloc();
+	lists[0].list = encList_Str__alloc();
+	lists[1].list = encList_Str__allocPool(pool);
+	for (k = 0; k < 2; k++) {
+		lists[k].strs = (char **)malloc(sizeof(char *) * 2 * MAX_LEN);
+		lists[k].n = 0;
+	}
+	split.strs = (char **)malloc(sizeof(char *) * 2 * MAX_LEN);
+	if (!pool || !lists[0].list || !lists[1].list || !lists[0].strs || !lists[1].strs ||
+	    !split.strs) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	encList_Str__setIndex(lists[0].list, 4);
+	encList_Str__setIndex(lists[1].list, 8);
+
+	for (step = 0; step < steps; step++) {
+		k = rng() % 2;
+		m = &lists[k];
+		other = &lists[1 - k];
+
+		switch (rng() % 10) {
+		case 0:
+		case 1:
+			if (m->n >= MAX_LEN)
+				break;
+			i = rng() % VOCAB;
+			encList_Str__addHead(m->list, vocab[i], 1);
+			modelInsert(m, 0, vocab[i]);
+			check(m, "addHead");
+			break;
+
+		case 2:
+		case 3:
+			if (m->n >= MAX_LEN)
+				break;
+			i = rng() % VOCAB;
+			encList_Str__addTail(m->list, vocab[i], 1);
+			modelInsert(m, m->n, vocab[i]);
+			check(m, "addTail");
+			break;
+
+		case 4:
+		case 5:
+			node = encList_Str__popHead(m->list);
+			if (!m->n) {
+				if (node)
+					fail("popHead", "an empty list returned a node");
+				break;
+			}
+			if (!node || strcmp(encNode_Str__getStr(node), m->strs[0]))
+				fail("popHead", "the wrong node was returned");
+			if (encNode_Str__getNext(node) || encNode_Str__getPrev(node))
+				fail("popHead", "the node is still linked");
+			encNode_Str__free(node);
+			memmove(m->strs, m->strs + 1, sizeof(char *) * --m->n);
+			check(m, "popHead");
+			break;
+
+		case 6:
+			/* Split, and move the back part to the end of the other list */
+			if (other->n + m->n > 2 * MAX_LEN)
+				break;
+			pos = rng() % (m->n + 1);
+			tail = encList_Str__splitAt(m->list, pos);
+			if (!tail)
+				fail("splitAt", "returned NULL");
+			split.list = tail;
+			split.n = 0;
+			memcpy(split.strs, m->strs + pos, sizeof(char *) * (m->n - pos));
+			split.n = m->n - pos;
+			m->n = pos;
+			check(m, "splitAt (front)");
+			check(&split, "splitAt (back)");
+
+			encList_Str__append(other->list, tail);
+			modelAppend(other, &split);
+			check(other, "append");
+			check(&split, "append (emptied)");
+			encList_Str__free(tail);
+			break;
+
+		case 7:
+			sortList(m);
+			check(m, "sort");
+			break;
+
+		case 8:
+			if (other->n + m->n > 2 * MAX_LEN)
+				break;
+			sortList(m);
+			sortList(other);
+			encList_Str__merge(m->list, other->list);
+			modelAppend(m, other);
+			qsort(m->strs, m->n, sizeof(char *), cmpStr);
+			check(m, "merge");
+			check(other, "merge (emptied)");
+			break;
+
+		case 9:
+			if (!m->n)
+				break;
+			pos = rng() % m->n;
+			node = encList_Str__index(m->list, pos);
+			if (!node || strcmp(encNode_Str__getStr(node), m->strs[pos]))
+				fail("index", "the wrong node was returned");
+			break;
+		}
+	}
+
+	encList_Str__free(lists[0].list);
+	encList_Str__free(lists[1].list);
+
+	tail = encList_Str__allocPool(pool);
+	encList_Str__setIndex(tail, 2);
+	for (i = 0; i < VOCAB; i++)
+		encList_Str__addTail(tail, vocab[i], 1);
+	if (!encList_Str__index(tail, VOCAB - 1))
+		fail("index", "the pooled list has no tail");
+	encPool_Str__free(pool);	/* and 'tail' with it */
+	free(lists[0].strs);
+	free(lists[1].strs);
+	free(split.strs);
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * test_encList_02_sortKeys.c
+ * Author:Qiwei Li
+ *
+ * Tests for the sort keys (EncKey_Str) and the ...By() methods: each case
+ * sorts a list of strings with sortBy(), and compares the result (and
+ * getMinBy()/getMaxBy()) with the expected order.  sortBy() is stable, so
+ * strings with equal keys must stay in their input order; and of several
+ * strings with the largest key, getMaxBy() returns the first.  A custom key
+ * whose function fails must leave the list as it was.
+ *
+ * Prints "PASS" and exits with 0 if every case passes; otherwise, prints
+ * each failure and exits with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+
+#define MAX_STRS	16
+
+typedef struct Case Case;
+struct Case {
+	const char	*name;
+	int		key;		/* see makeKey() */
+	const char	*max;		/* what getMaxBy() returns */
+	const char	*in[MAX_STRS];	/* NULL-terminated */
+	const char	*out[MAX_STRS];
+};
+
+static Case cases[] = {
+	{ "numeric", 0, "10",
+	  { "10", "-5", "3", "abc", "+7", "007", " 2x", "-0", NULL },
+	  { "-5", "abc", "-0", " 2x", "3", "+7", "007", "10", NULL } },
+
+	/* Values past the range of a 64-bit integer saturate (and so tie),
+	 * rather than wrapping around
+	 */
+	{ "numeric overflow", 0, "92233720368547758080",
+	  { "92233720368547758080", "5", "20000000000000000000", "9223372036854775807",
+	    "18446744073709551616", "-92233720368547758080", "-9223372036854775808",
+	    "-9223372036854775807", "9223372036854775806", NULL },
+	  { "-92233720368547758080", "-9223372036854775808", "-9223372036854775807", "5",
+	    "9223372036854775806", "92233720368547758080", "20000000000000000000",
+	    "9223372036854775807", "18446744073709551616", NULL } },
+
+	{ "fold", 1, "Cherry, which is long enough not to be inline",
+	  { "banana", "Apple", "cherry", "apple", "BANANA",
+	    "Cherry, which is long enough not to be inline", NULL },
+	  { "Apple", "apple", "banana", "BANANA", "cherry",
+	    "Cherry, which is long enough not to be inline", NULL } },
+
+	{ "numeric field", 2, "x,10,q",
+	  { "x,10,q", "y,2,p", "z,-3", "w,2,a", "v", NULL },
+	  { "z,-3", "v", "y,2,p", "w,2,a", "x,10,q", NULL } },
+
+	{ "plain field", 3, "y,2,p",
+	  { "x,10,q", "y,2,p", "z,-3", "w,2,a", "v", NULL },
+	  { "v", "z,-3", "x,10,q", "y,2,p", "w,2,a", NULL } },
+
+	{ "custom (reversed)", 4, "cc",
+	  { "ab", "ba", "cc", "ac", NULL },
+	  { "ba", "ab", "ac", "cc", NULL } },
+};
+#define NCASES	((int)(sizeof(cases) / sizeof(cases[0])))
+
+static int failures;
+
+
+/* Sorts by the string read backward */
+static int reversed(const char *str, int len, char *key, int cap, void *arg)
+{
+	int i;
+
+	if (cap < len)
+		return len;
+	for (i = 0; i < len; i++)
+		key[i] = str[len - 1 - i];
+	return len;
+}
+
+/* Like reversed(), but fails for strings which start with 'x' */
+static int failing(const char *str, int len, char *key, int cap, void *arg)
+{
+	if (len && str[0] == 'x')
+		return -1;
+	return reversed(str, len, key, cap, arg);
+}
+
+static EncKey_Str *makeKey(int which)
+{
+	switch (which) {
+	case 0: return encKey_Str__allocNumeric();
+	case 1: return encKey_Str__allocFold();
+	case 2: return encKey_Str__allocField(',', 2, encKey_Str__allocNumeric());
+	case 3: return encKey_Str__allocField(',', 2, NULL);
+	default: return encKey_Str__allocCustom(reversed, NULL);
+	}
+}
+
+static void fail(const char *name, const char *why)
+{
+	printf("FAIL (%s): %s\n", name, why);
+	failures++;
+}
+
+static void runCase(Case *c)
+{
+	EncList_Str *list = encList_Str__alloc();
+	EncKey_Str *key = makeKey(c->key);
+	EncNode_Str *node;
+	int i, n;
+
+	for (n = 0; c->in[n]; n++)
+		encList_Str__addTail(list, (char *)c->in[n], 1);
+
+	if (strcmp(encList_Str__getMinBy(list, key), c->out[0]))
+		fail(c->name, "getMinBy() is wrong");
+	if (strcmp(encList_Str__getMaxBy(list, key), c->max))
+		fail(c->name, "getMaxBy() is wrong");
+
+	encList_Str__sortBy(list, key);
+	if (encList_Str__count(list) != n)
+		fail(c->name, "sortBy() changed the count");
+	for (i = 0, node = encList_Str__getHead(list); node; i++, node = encNode_Str__getNext(node)) {
+		if (i >= n || strcmp(encNode_Str__getStr(node), c->out[i])) {
+			fail(c->name, "sortBy() gave the wrong order");
+			break;
+		}
+	}
+
+	encList_Str__free(list);
+	encKey_Str__free(key);
+}
+
+/* mergeBy() of two lists sorted by the same key */
+static void runMerge()
+{
+	EncList_Str *lhs = encList_Str__alloc(), *rhs = encList_Str__alloc();
+	EncKey_Str *key = encKey_Str__allocNumeric();
+	const char *expect[] = { "1", "2", "3", "5", "9", "10", "12", "100" };
+	EncNode_Str *node;
+	int i;
+
+	encList_Str__addTail(lhs, "1", 1);
+	encList_Str__addTail(lhs, "5", 1);
+	encList_Str__addTail(lhs, "9", 1);
+	encList_Str__addTail(lhs, "12", 1);
+	encList_Str__addTail(rhs, "2", 1);
+	encList_Str__addTail(rhs, "3", 1);
+	encList_Str__addTail(rhs, "10", 1);
+	encList_Str__addTail(rhs, "100", 1);
+
+	encList_Str__mergeBy(lhs, rhs, key);
+	if (encList_Str__count(lhs) != 8 || encList_Str__count(rhs) != 0)
+		fail("mergeBy", "the counts are wrong");
+	for (i = 0, node = encList_Str__getHead(lhs); node && i < 8; i++, node = encNode_Str__getNext(node)) {
+		if (strcmp(encNode_Str__getStr(node), expect[i])) {
+			fail("mergeBy", "the wrong order");
+			break;
+		}
+	}
+
+	encList_Str__free(lhs);
+	encList_Str__free(rhs);
+	encKey_Str__free(key);
+}
+
+/* sortBy() and getMinBy() with a key which fails part way through the list */
+static void runFailing()
+{
+	EncList_Str *list = encList_Str__alloc();
+	EncKey_Str *key = encKey_Str__allocCustom(failing, NULL);
+	const char *in[] = { "bc", "ab", "xy", "ca" };
+	EncNode_Str *node;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		encList_Str__addTail(list, (char *)in[i], 1);
+
+	encList_Str__sortBy(list, key);
+	if (encList_Str__count(list) != 4)
+		fail("failing key", "sortBy() changed the count");
+	for (i = 0, node = encList_Str__getHead(list); node && i < 4; i++, node = encNode_Str__getNext(node)) {
+		if (strcmp(encNode_Str__getStr(node), in[i]) || encNode_Str__getLen(node) != 2) {
+			fail("failing key", "sortBy() changed the list");
+			break;
+		}
+	}
+	if (encList_Str__getMinBy(list, key))
+		fail("failing key", "getMinBy() did not fail");
+
+	encList_Str__free(list);
+	encKey_Str__free(key);
+}
+
+int main()
+{
+	int i;
+
+	for (i = 0; i < NCASES; i++)
+		runCase(&cases[i]);
+	runMerge();
+	runFailing();
+
+	if (failures)
+		return 1;
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * test_encList_03_saveLoad.c
+ * Author:Qiwei Li
+ *
+ * Tests for encList_Str__save() and encList_Str__load(): a list saved and
+ * loaded again must hold the same strings, and load() must reject a file
+ * which has been damaged in any of the ways it checks for (each case below
+ * breaks one thing in an otherwise good file).
+ *
+ * USAGE:
+ *   test_encList_03_saveLoad [scratch file]
+ *
+ * Prints "PASS" and exits with 0 if every case passes; otherwise, prints
+ * each failure and exits with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+
+/* The layout that save() writes; see encapsulatedListStr.c */
+#define HDR_SIZE	32	/* magic, order, count, blobSize */
+#define ENTRY_SIZE	24	/* key, offset, len */
+
+static const char *strs[] = {
+	"pear", "apple", "", "a string which is too long to be stored inline", "fig",
+};
+#define NSTRS	((int)(sizeof(strs) / sizeof(strs[0])))
+
+static const char *path;
+static char *good;
+static long goodSize;
+static int failures;
+
+
+static void fail(const char *name, const char *why)
+{
+	printf("FAIL (%s): %s\n", name, why);
+	failures++;
+}
+
+static void writeFile(const char *buf, long size)
+{
+	FILE *fp = fopen(path, "wb");
+
+	if (!fp || fwrite(buf, 1, size, fp) != (size_t)size || fclose(fp) != 0) {
+		perror(path);
+		exit(1);
+	}
+}
+
+/* Offsets of the fields of table entry 'i' */
+static long entryKey(int i)
+{
+	return HDR_SIZE + i * ENTRY_SIZE;
+}
+static long entryOffset(int i)
+{
+	return entryKey(i) + 8;
+}
+static long entryLen(int i)
+{
+	return entryKey(i) + 16;
+}
+
+static uint64_t get64(const char *buf, long at)
+{
+	uint64_t val;
+
+	memcpy(&val, buf + at, sizeof(val));
+	return val;
+}
+static void put64(char *buf, long at, uint64_t val)
+{
+	memcpy(buf + at, &val, sizeof(val));
+}
+
+/* Offset of the string of entry 'i' in the file */
+static long strAt(int i)
+{
+	return HDR_SIZE + NSTRS * ENTRY_SIZE + (long)get64(good, entryOffset(i));
+}
+
+/* Loads a copy of the good file, damaged by 'damage()', and checks that it
+ * is rejected
+ */
+static void expectReject(const char *name, void (*damage)(char *buf, long *size))
+{
+	EncPool_Str *pool = encPool_Str__alloc();
+	char *buf = (char *)malloc(goodSize);
+	long size = goodSize;
+
+	memcpy(buf, good, goodSize);
+	damage(buf, &size);
+	writeFile(buf, size);
+	if (encList_Str__load(pool, (char *)path))
+		fail(name, "a damaged file was loaded");
+
+	/* The pool still owns the mapping; freeing it must release that */
+	encPool_Str__free(pool);
+	free(buf);
+}
+
+static void badMagic(char *buf, long *size)
+{
+	buf[0] ^= 1;
+}
+static void truncated(char *buf, long *size)
+{
+	(*size)--;
+}
+static void badOffset(char *buf, long *size)
+{
+	put64(buf, entryOffset(1), get64(buf, entryOffset(1)) + (1ULL << 40));
+}
+static void hugeLen(char *buf, long *size)
+{
+	put64(buf, entryLen(3), (uint64_t)UINT32_MAX + 1);
+}
+static void badLen(char *buf, long *size)
+{
+	put64(buf, entryLen(1), get64(buf, entryLen(1)) - 1);
+}
+static void badLenPrefix(char *buf, long *size)
+{
+	buf[strAt(0) - 4] ^= 1;
+}
+static void noNul(char *buf, long *size)
+{
+	buf[strAt(4) + strlen(strs[4])] = 'x';
+}
+static void badKey(char *buf, long *size)
+{
+	put64(buf, entryKey(0), get64(buf, entryKey(0)) + 1);
+}
+static void badString(char *buf, long *size)
+{
+	buf[strAt(1)] = 'b';	/* the key still says "apple" */
+}
+
+int main(int argc, char **argv)
+{
+	EncPool_Str *pool;
+	EncList_Str *list;
+	EncNode_Str *node;
+	FILE *fp;
+	int i;
+
+	path = argc > 1 ? argv[1] : "test_encList_03_saveLoad.tmp";
+
+	/* A good file, and a list loaded from it */
+	list = encList_Str__alloc();
+	for (i = 0; i < NSTRS; i++)
+		encList_Str__addTail(list, (char *)strs[i], 1);
+	if (encList_Str__save(list, (char *)path) < 0) {
+		printf("FAIL: the list could not be saved\n");
+		return 1;
+	}
+	encList_Str__free(list);
+
+	fp = fopen(path, "rb");
+	if (!fp || fseek(fp, 0, SEEK_END) < 0 || (goodSize = ftell(fp)) < 0) {
+		perror(path);
+		return 1;
+	}
+	good = (char *)malloc(goodSize);
+	rewind(fp);
+	if (!good || fread(good, 1, goodSize, fp) != (size_t)goodSize) {
+		perror(path);
+		return 1;
+	}
+	fclose(fp);
+
+	pool = encPool_Str__alloc();
+	list = encList_Str__load(pool, (char *)path);
+	if (!list)
+		fail("load", "a good file was rejected");
+	else {
+		if (encList_Str__count(list) != NSTRS)
+			fail("load", "the count is wrong");
+		for (i = 0, node = encList_Str__getHead(list); node && i < NSTRS;
+		     i++, node = encNode_Str__getNext(node)) {
+			if (strcmp(encNode_Str__getStr(node), strs[i]) ||
+			    encNode_Str__getLen(node) != (int)strlen(strs[i])) {
+				fail("load", "a string is wrong");
+				break;
+			}
+		}
+		encList_Str__sort(list);
+		if (strcmp(encList_Str__getMin(list), "") || strcmp(encList_Str__getMax(list), "pear"))
+			fail("load", "the loaded list does not sort");
+	}
+	encPool_Str__free(pool);
+
+	expectReject("bad magic", badMagic);
+	expectReject("truncated", truncated);
+	expectReject("offset out of the blob", badOffset);
+	expectReject("length over 4G", hugeLen);
+	expectReject("length too short", badLen);
+	expectReject("length prefix", badLenPrefix);
+	expectReject("no NUL", noNul);
+	expectReject("key prefix", badKey);
+	expectReject("string changed", badString);
+
+	remove(path);
+	free(good);
+
+	if (failures)
+		return 1;
+	printf("PASS\n");
+	return 0;
+}
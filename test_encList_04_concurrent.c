@@ -0,0 +1,251 @@
+/*
+ * test_encList_04_concurrent.c
+ * Author:Qiwei Li
+ *
+ * Multi-threaded test for EncStack_Str and EncQueue_Str.  A few producer
+ * threads push numbered strings onto one stack and one queue, while a few
+ * consumer threads take them off again - one at a time with popHead(), and
+ * now and then all at once with drain().  At the end, every string must have
+ * come off of each of the two exactly once; and each consumer must have seen
+ * the strings of any one producer in the order that they were added to the
+ * queue (and, within each batch from drain(), to the stack).
+ *
+ * Since a node popped off of the stack must not be freed while another
+ * consumer could be in popHead() (see encapsulatedListStr.c), the consumers
+ * keep those until every thread is done.
+ *
+ * USAGE:
+ *   test_encList_04_concurrent [strings per producer]
+ *
+ * Prints "PASS" and exits with 0 if every check passes; otherwise, prints
+ * the first failure and exits with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "encapsulatedListStr.h"
+#include "encapsulatedListStrExt.h"
+
+#define PRODUCERS	4
+#define CONSUMERS	3
+#define DRAIN_EVERY	64	/* a consumer drains once every so many pops */
+
+typedef struct Consumer Consumer;
+struct Consumer {
+	pthread_t	thread;
+	EncList_Str	*kept;		/* everything taken off of the stack */
+	EncNode_Str	**popped;	/* ... the ones from popHead() */
+	long		nPopped;
+	EncList_Str	*drained;	/* scratch list for drain() of the queue */
+};
+
+static EncStack_Str *stack;
+static EncQueue_Str *queue;
+static long perProducer;
+static int producersLeft;
+static unsigned char *seenStack, *seenQueue;
+
+
+static void fail(const char *what, const char *why)
+{
+	printf("FAIL (%s): %s\n", what, why);
+	exit(1);
+}
+
+/* Splits a string from a producer back into its producer and number, and
+ * marks it as seen; 'last' holds the last number seen from each producer
+ * (or NULL, to skip the check of the order)
+ */
+static void see(const char *what, char *str, unsigned char *seen, long *last)
+{
+	int p;
+	long i;
+
+	if (sscanf(str, "%d:%ld", &p, &i) != 2 || p < 0 || p >= PRODUCERS ||
+	    i < 0 || i >= perProducer)
+		fail(what, "a string was garbled");
+	if (__atomic_fetch_add(&seen[p * perProducer + i], 1, __ATOMIC_RELAXED))
+		fail(what, "a string came off twice");
+	if (last) {
+		if (i <= last[p])
+			fail(what, "the strings of a producer came out of order");
+		last[p] = i;
+	}
+}
+
+static void *producer(void *arg)
+{
+	int p = (int)(long)arg;
+	char buf[32];
+	long i;
+
+	for (i = 0; i < perProducer; i++) {
+		sprintf(buf, "%d:%ld", p, i);
+		encStack_Str__pushHead(stack, buf, 1);
+		encQueue_Str__addTail(queue, buf, 1);
+	}
+	__atomic_fetch_sub(&producersLeft, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/* Drains the stack onto c->kept, and the queue onto c->drained (freeing
+ * those); returns how many nodes were moved
+ */
+static int drainBoth(Consumer *c, long *lastQueue)
+{
+	EncNode_Str *node, *old;
+	long last[PRODUCERS];
+	int n, got, p;
+
+	/* The stack keeps the order in which the nodes were pushed within one
+	 * batch only: other consumers took some of them in between
+	 */
+	for (p = 0; p < PRODUCERS; p++)
+		last[p] = -1;
+	old = encList_Str__getTail(c->kept);
+	n = encStack_Str__drain(stack, c->kept);
+	if (n < 0)
+		fail("drain (stack)", "returned an error");
+	node = old ? encNode_Str__getNext(old) : encList_Str__getHead(c->kept);
+	for (got = 0; node; node = encNode_Str__getNext(node), got++)
+		see("drain (stack)", encNode_Str__getStr(node), seenStack, last);
+	if (got != n)
+		fail("drain (stack)", "returned the wrong count");
+
+	got = encQueue_Str__drain(queue, c->drained);
+	if (got < 0)
+		fail("drain (queue)", "returned an error");
+	if (encList_Str__count(c->drained) != got)
+		fail("drain (queue)", "returned the wrong count");
+	while ((node = encList_Str__popHead(c->drained))) {
+		see("drain (queue)", encNode_Str__getStr(node), seenQueue, lastQueue);
+		encNode_Str__free(node);
+	}
+
+	return n + got;
+}
+
+static void *consumer(void *arg)
+{
+	Consumer *c = (Consumer *)arg;
+	EncNode_Str *node;
+	long lastQueue[PRODUCERS], pops = 0;
+	int p, done, got;
+
+	for (p = 0; p < PRODUCERS; p++)
+		lastQueue[p] = -1;
+
+	do {
+		/* Read this first: once it is 0, everything has been added */
+		done = !__atomic_load_n(&producersLeft, __ATOMIC_ACQUIRE);
+		got = 0;
+
+		if (++pops % DRAIN_EVERY == 0)
+			got += drainBoth(c, lastQueue);
+
+		node = encStack_Str__popHead(stack);
+		if (node) {
+			see("popHead (stack)", encNode_Str__getStr(node), seenStack, NULL);
+			c->popped[c->nPopped++] = node;
+			got++;
+		}
+		node = encQueue_Str__popHead(queue);
+		if (node) {
+			see("popHead (queue)", encNode_Str__getStr(node), seenQueue, lastQueue);
+			encNode_Str__free(node);
+			got++;
+		}
+	} while (!done || got);
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t producers[PRODUCERS];
+	Consumer consumers[CONSUMERS];
+	EncPool_Str *pool;
+	EncList_Str *list;
+	EncNode_Str *node;
+	long i, n;
+	int k;
+
+	perProducer = argc > 1 ? atol(argv[1]) : 20000;
+	n = PRODUCERS * perProducer;
+
+	stack = encStack_Str__alloc();
+	queue = encQueue_Str__alloc();
+	seenStack = (unsigned char *)calloc(n, 1);
+	seenQueue = (unsigned char *)calloc(n, 1);
+	if (!stack || !queue || !seenStack || !seenQueue) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+	for (k = 0; k < CONSUMERS; k++) {
+		consumers[k].kept = encList_Str__alloc();
+		consumers[k].drained = encList_Str__alloc();
+		consumers[k].popped = (EncNode_Str **)malloc(sizeof(EncNode_Str *) * n);
+		consumers[k].nPopped = 0;
+		if (!consumers[k].kept || !consumers[k].drained || !consumers[k].popped) {
+			printf("FAIL: out of memory\n");
+			return 1;
+		}
+	}
+
+	producersLeft = PRODUCERS;
+	for (k = 0; k < CONSUMERS; k++)
+		pthread_create(&consumers[k].thread, NULL, consumer, &consumers[k]);
+	for (k = 0; k < PRODUCERS; k++)
+		pthread_create(&producers[k], NULL, producer, (void *)(long)k);
+	for (k = 0; k < PRODUCERS; k++)
+		pthread_join(producers[k], NULL);
+	for (k = 0; k < CONSUMERS; k++)
+		pthread_join(consumers[k].thread, NULL);
+
+	for (i = 0; i < n; i++) {
+		if (!seenStack[i])
+			fail("stack", "a string never came off");
+		if (!seenQueue[i])
+			fail("queue", "a string never came off");
+	}
+	if (encStack_Str__popHead(stack) || encQueue_Str__popHead(queue))
+		fail("the end", "a string was left behind");
+
+	for (k = 0; k < CONSUMERS; k++) {
+		for (i = 0; i < consumers[k].nPopped; i++)
+			encNode_Str__free(consumers[k].popped[i]);
+		free(consumers[k].popped);
+		encList_Str__free(consumers[k].kept);
+		encList_Str__free(consumers[k].drained);
+	}
+
+	/* drain() must not hand malloc()ed nodes to a list from a pool */
+	pool = encPool_Str__alloc();
+	list = encList_Str__allocPool(pool);
+	encStack_Str__pushHead(stack, "stack", 1);
+	encQueue_Str__addTail(queue, "queue", 1);
+	if (encStack_Str__drain(stack, list) != -1 || encQueue_Str__drain(queue, list) != -1)
+		fail("drain (pool)", "a list from a pool was accepted");
+	if (encList_Str__count(list) != 0)
+		fail("drain (pool)", "the list from a pool was changed");
+	node = encStack_Str__popHead(stack);
+	if (!node || strcmp(encNode_Str__getStr(node), "stack"))
+		fail("drain (pool)", "the stack was changed");
+	encNode_Str__free(node);
+	node = encQueue_Str__popHead(queue);
+	if (!node || strcmp(encNode_Str__getStr(node), "queue"))
+		fail("drain (pool)", "the queue was changed");
+	encNode_Str__free(node);
+	encPool_Str__free(pool);
+
+	encStack_Str__free(stack);
+	encQueue_Str__free(queue);
+	free(seenStack);
+	free(seenQueue);
+
+	printf("PASS\n");
+	return 0;
+}
@@ -0,0 +1,279 @@
+/*
+ * test_encUList_01_invariants.c
+ * Author:Qiwei Li
+ *
+ * Stress test for EncUList_Str.  Runs a long random sequence of addHead(),
+ * addTail(), insertAt(), removeAt(), splitAt() and append(), sort(), merge(),
+ * index() and getMin()/getMax() on a pair of lists, and after every step
+ * checks both lists against a plain array of the strings they should hold:
+ * the count, the head and the tail, and every string, both through an
+ * iterator and through index().
+ *
+ * The lists grow well past one block, and insertAt() and removeAt() are
+ * called often enough that blocks are split, and merged into their
+ * neighbors, all the time.  Some of the strings are short enough to be
+ * stored inline in the blocks, and the others are not; some are duplicated
+ * (dup=1), and the others are not.
+ *
+ * USAGE:
+ *   test_encUList_01_invariants [seed [steps]]
+ *
+ * Prints "PASS" and exits with 0 if every check passes; otherwise, prints
+ * the first failure and exits with 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "encUnrolledListStr.h"
+
+#define MAX_LEN		400	/* lists longer than this only shrink */
+#define VOCAB		64	/* distinct strings (so there are duplicates) */
+
+typedef struct Model Model;
+struct Model {
+	EncUList_Str	*list;
+	char		**strs;
+	int		n;
+};
+
+static char vocab[VOCAB][48];
+static unsigned long long rngState;
+static long step;
+
+
+static unsigned int rng()
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 7;
+	rngState ^= rngState << 17;
+	return (unsigned int)(rngState >> 16);
+}
+
+static void fail(const char *what, const char *why)
+{
+	printf("FAIL at step %ld (%s): %s\n", step, what, why);
+	exit(1);
+}
+
+static int cmpStr(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Checks a string returned by the list against the one the model holds */
+static int same(const char *str, const char *expect)
+{
+	return str && !strcmp(str, expect);
+}
+
+/* Checks every invariant of a list against its model */
+static void check(Model *m, const char *what)
+{
+	EncUList_Str_Iter it;
+	char *str;
+	int i = 0;
+
+	if (encUList_Str__count(m->list) != m->n)
+		fail(what, "count() is wrong");
+
+	encUList_Str__iter(m->list, &it);
+	while ((str = encUList_Str__iterNext(&it))) {
+		if (i >= m->n)
+			fail(what, "the list is longer than count()");
+		if (strcmp(str, m->strs[i]))
+			fail(what, "a string is wrong");
+		i++;
+	}
+	if (i != m->n)
+		fail(what, "the list is shorter than count()");
+
+	if (!m->n) {
+		if (encUList_Str__getHead(m->list) || encUList_Str__getTail(m->list))
+			fail(what, "an empty list has a head or a tail");
+		return;
+	}
+	if (!same(encUList_Str__getHead(m->list), m->strs[0]))
+		fail(what, "getHead() is wrong");
+	if (!same(encUList_Str__getTail(m->list), m->strs[m->n - 1]))
+		fail(what, "getTail() is wrong");
+
+	/* index() finds its way through the blocks from either end */
+	for (i = 0; i < 4; i++) {
+		int pos = rng() % m->n;
+
+		if (!same(encUList_Str__index(m->list, pos), m->strs[pos]))
+			fail(what, "index() is wrong");
+	}
+}
+
+/* Inserts 'str' into the model at position 'pos' */
+static void modelInsert(Model *m, int pos, char *str)
+{
+	memmove(m->strs + pos + 1, m->strs + pos, sizeof(char *) * (m->n - pos));
+	m->strs[pos] = str;
+	m->n++;
+}
+
+/* Moves all of src's model onto the end of dst's */
+static void modelAppend(Model *dst, Model *src)
+{
+	memcpy(dst->strs + dst->n, src->strs, sizeof(char *) * src->n);
+	dst->n += src->n;
+	src->n = 0;
+}
+
+static void sortList(Model *m)
+{
+	encUList_Str__sort(m->list);
+	qsort(m->strs, m->n, sizeof(char *), cmpStr);
+}
+
+int main(int argc, char **argv)
+{
+	EncUList_Str *tail;
+	Model lists[2], *m, *other, split;
+	char *str, **sorted;
+	long steps;
+	int i, k, pos;
+
+	rngState = argc > 1 ? strtoull(argv[1], NULL, 0) : 88172645463325252ULL;
+	steps = argc > 2 ? atol(argv[2]) : 50000;
+	if (!rngState)
+		rngState = 1;
+
+	for (i = 0; i < VOCAB; i++) {
+		if (i % 2)
+			sprintf(vocab[i], "s%02d", i);
+		else
+			sprintf(vocab[i], "a longer string, which is not inline: %02d", i);
+	}
+
+	for (k = 0; k < 2; k++) {
+		lists[k].list = encUList_Str__alloc();
+		lists[k].strs = (char **)malloc(sizeof(char *) * 2 * MAX_LEN);
+		lists[k].n = 0;
+	}
+	split.strs = (char **)malloc(sizeof(char *) * 2 * MAX_LEN);
+	sorted = (char **)malloc(sizeof(char *) * 2 * MAX_LEN);
+	if (!lists[0].list || !lists[1].list || !lists[0].strs || !lists[1].strs ||
+	    !split.strs || !sorted) {
+		printf("FAIL: out of memory\n");
+		return 1;
+	}
+
+	for (step = 0; step < steps; step++) {
+		k = rng() % 2;
+		m = &lists[k];
+		other = &lists[1 - k];
+
+		switch (rng() % 12) {
+		case 0:
+			if (m->n >= MAX_LEN)
+				break;
+			i = rng() % VOCAB;
+			encUList_Str__addHead(m->list, vocab[i], rng() % 2);
+			modelInsert(m, 0, vocab[i]);
+			check(m, "addHead");
+			break;
+
+		case 1:
+		case 2:
+			if (m->n >= MAX_LEN)
+				break;
+			i = rng() % VOCAB;
+			encUList_Str__addTail(m->list, vocab[i], rng() % 2);
+			modelInsert(m, m->n, vocab[i]);
+			check(m, "addTail");
+			break;
+
+		case 3:
+		case 4:
+			if (m->n >= MAX_LEN)
+				break;
+			i = rng() % VOCAB;
+			pos = rng() % (m->n + 1);
+			encUList_Str__insertAt(m->list, pos, vocab[i], rng() % 2);
+			modelInsert(m, pos, vocab[i]);
+			check(m, "insertAt");
+			break;
+
+		case 5:
+		case 6:
+			if (!m->n)
+				break;
+			pos = rng() % m->n;
+			encUList_Str__removeAt(m->list, pos);
+			memmove(m->strs + pos, m->strs + pos + 1, sizeof(char *) * (m->n - pos - 1));
+			m->n--;
+			check(m, "removeAt");
+			break;
+
+		case 7:
+			/* Split, and move the back part to the end of the other list */
+			if (other->n + m->n > 2 * MAX_LEN)
+				break;
+			pos = rng() % (m->n + 1);
+			tail = encUList_Str__splitAt(m->list, pos);
+			if (!tail)
+				fail("splitAt", "returned NULL");
+			split.list = tail;
+			memcpy(split.strs, m->strs + pos, sizeof(char *) * (m->n - pos));
+			split.n = m->n - pos;
+			m->n = pos;
+			check(m, "splitAt (front)");
+			check(&split, "splitAt (back)");
+
+			encUList_Str__append(other->list, tail);
+			modelAppend(other, &split);
+			check(other, "append");
+			check(&split, "append (emptied)");
+			encUList_Str__free(tail);
+			break;
+
+		case 8:
+			sortList(m);
+			check(m, "sort");
+			break;
+
+		case 9:
+			if (other->n + m->n > 2 * MAX_LEN)
+				break;
+			sortList(m);
+			sortList(other);
+			encUList_Str__merge(m->list, other->list);
+			modelAppend(m, other);
+			qsort(m->strs, m->n, sizeof(char *), cmpStr);
+			check(m, "merge");
+			check(other, "merge (emptied)");
+			break;
+
+		case 10:
+		case 11:
+			str = encUList_Str__getMin(m->list);
+			if (!m->n) {
+				if (str || encUList_Str__getMax(m->list))
+					fail("getMin/getMax", "an empty list returned a string");
+				break;
+			}
+			memcpy(sorted, m->strs, sizeof(char *) * m->n);
+			qsort(sorted, m->n, sizeof(char *), cmpStr);
+			if (!same(str, sorted[0]))
+				fail("getMin", "the wrong string was returned");
+			if (!same(encUList_Str__getMax(m->list), sorted[m->n - 1]))
+				fail("getMax", "the wrong string was returned");
+			break;
+		}
+	}
+
+	encUList_Str__free(lists[0].list);
+	encUList_Str__free(lists[1].list);
+	free(lists[0].strs);
+	free(lists[1].strs);
+	free(split.strs);
+	free(sorted);
+
+	printf("PASS\n");
+	return 0;
+}